@@ -0,0 +1,48 @@
+#include "assets.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <stddef.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Contents of tiles.png and font.ttf, generated into assets_data.c by tools/embed.c at build time
+extern const unsigned char tilesPng[];
+extern const size_t tilesPngSize;
+extern const unsigned char fontTtf[];
+extern const size_t fontTtfSize;
+
+// Decode tile image embedded in the executable
+// Does not use the renderer, so it can run on another thread
+// Returns NULL on failure
+SDL_Surface *decodeTiles(void)
+{
+    SDL_RWops *data = SDL_RWFromConstMem(tilesPng, (int)tilesPngSize);
+    if (data == NULL)
+        return NULL;
+    return IMG_Load_RW(data, 1);
+}
+
+// Decode tile texture embedded in the executable
+// Returns NULL on failure
+SDL_Texture *loadTiles(SDL_Renderer *renderer)
+{
+    SDL_RWops *data = SDL_RWFromConstMem(tilesPng, (int)tilesPngSize);
+    if (data == NULL)
+        return NULL;
+    return IMG_LoadTexture_RW(renderer, data, 1);
+}
+
+// Open font embedded in the executable
+// TTF_Init must be called first
+// Returns NULL on failure
+TTF_Font *loadFont(int size)
+{
+    SDL_RWops *data = SDL_RWFromConstMem(fontTtf, (int)fontTtfSize);
+    if (data == NULL)
+        return NULL;
+    return TTF_OpenFontRW(data, 1, size); // font reads embedded data while it is open, it is never freed
+}
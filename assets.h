@@ -0,0 +1,12 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+
+SDL_Surface *decodeTiles(void);
+SDL_Texture *loadTiles(SDL_Renderer *renderer);
+TTF_Font *loadFont(int size);
+
+#endif
@@ -0,0 +1,265 @@
+#include "../file.h"
+#include "../move.h"
+#include "../solver.h"
+#include "../play.h"
+#include "../tiles.h"
+#include "../assets.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef DEBUGMALLOC
+#include "../debugmalloc.h"
+#endif
+
+#define MIN_SECONDS 0.5 // every measurement repeats its work at least this long
+
+// Get current time in seconds
+static double now(void)
+{
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// Print one result line: benchmark name, value, unit
+static void report(char *name, double value, char *unit)
+{
+    printf("%s\t%.3f\t%s\n", name, value, unit);
+}
+
+// Count levels of linked list
+static int countLevels(Level *level)
+{
+    int count = 0;
+    for (; level != NULL; level = level->next)
+        count++;
+    return count;
+}
+
+// Time loading and saving of collections
+// Returns false if a collection cannot be loaded
+static bool benchFiles(char **files, int fileCount)
+{
+    long levels = 0, bytes = 0, saved = 0;
+    double start = now(), seconds;
+    do
+    {
+        for (int i = 0; i < fileCount; i++)
+        {
+            LoadLevelResult result = loadLevel(files[i]);
+            if (result.result != 0 && result.result != 4)
+            {
+                fprintf(stderr, "ERROR: Couldn't load %s (%d)\n", files[i], result.result);
+                unloadLevel(result.level);
+                return false;
+            }
+            levels += countLevels(result.level);
+            unloadLevel(result.level);
+            FILE *file = fopen(files[i], "rb");
+            if (file != NULL)
+            {
+                fseek(file, 0, SEEK_END);
+                bytes += ftell(file);
+                fclose(file);
+            }
+        }
+        seconds = now() - start;
+    } while (seconds < MIN_SECONDS);
+    report("load_levels_per_second", levels / seconds, "levels/s");
+    report("load_bytes_per_second", bytes / seconds, "bytes/s");
+
+    LoadLevelResult result = loadLevel(files[0]);
+    int count = countLevels(result.level);
+    start = now();
+    do
+    {
+        if (!saveLevel(result.level, "bench.tmp.xsb", false))
+        {
+            fprintf(stderr, "ERROR: Couldn't save levels\n");
+            break;
+        }
+        saved += count;
+        seconds = now() - start;
+    } while (seconds < MIN_SECONDS);
+    report("save_levels_per_second", saved / seconds, "levels/s");
+    remove("bench.tmp.xsb");
+    unloadLevel(result.level);
+    return true;
+}
+
+// Time random walks of the move kernel, every attempt counts as a move
+static void benchMoves(Level *levels)
+{
+    unsigned long long seed = 88172645463325252ULL;
+    long moves = 0;
+    double start = now(), seconds;
+    do
+    {
+        for (Level *level = levels; level != NULL; level = level->next)
+        {
+            int count = level->size.x * level->size.y;
+            TileState *original = (TileState *)malloc(sizeof(TileState) * count);
+            if (original == NULL)
+                return;
+            memcpy(original, level->tiles, sizeof(TileState) * count);
+            Coordinates player;
+            if (takePlayer(level, &player))
+            {
+                for (int i = 0; i < 10000; i++)
+                {
+                    seed ^= seed << 13; // xorshift64
+                    seed ^= seed >> 7;
+                    seed ^= seed << 17;
+                    movePlayer(level, &player, (int)(seed % 4));
+                }
+                moves += 10000;
+            }
+            memcpy(level->tiles, original, sizeof(TileState) * count); // restore level for next round
+            free(original);
+        }
+        seconds = now() - start;
+    } while (seconds < MIN_SECONDS);
+    report("moves_per_second", moves / seconds, "moves/s");
+}
+
+// Time solver on every level of every collection with a node limit
+// Total nodes only change when the search itself changes
+static void benchSolver(char **files, int fileCount, long maxNodes)
+{
+    long nodes = 0;
+    int solved = 0;
+    double seconds = 0;
+    for (int i = 0; i < fileCount; i++)
+    {
+        LoadLevelResult levels = loadLevel(files[i]);
+        for (Level *level = levels.level; level != NULL; level = level->next)
+        {
+            SolverLimits limits = {maxNodes, 0, NULL, NULL, false};
+            SolverResult result = solveLevel(level, limits);
+            nodes += result.nodes;
+            seconds += result.seconds;
+            solved += result.result == 0;
+            freeSolverResult(&result);
+        }
+        unloadLevel(levels.level);
+    }
+    report("solver_levels_solved", solved, "levels");
+    report("solver_nodes", nodes, "nodes");
+    if (seconds > 0)
+        report("solver_nodes_per_second", nodes / seconds, "nodes/s");
+}
+
+// Time frames of play rendered to an offscreen surface
+// Returns false if SDL cannot be initialized
+static bool benchRender(Level *levels)
+{
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0); // no window is needed
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+        return false;
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, 1280, 768, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer *renderer = surface == NULL ? NULL : SDL_CreateSoftwareRenderer(surface);
+    SDL_Texture *tiles = renderer == NULL ? NULL : loadTiles(renderer);
+    TTF_Init();
+    TTF_Font *font = loadFont(50);
+    if (tiles == NULL || font == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't load embedded tiles or font\n");
+        if (font != NULL)
+            TTF_CloseFont(font);
+        if (tiles != NULL)
+            SDL_DestroyTexture(tiles);
+        if (renderer != NULL)
+            SDL_DestroyRenderer(renderer);
+        if (surface != NULL)
+            SDL_FreeSurface(surface);
+        TTF_Quit();
+        SDL_Quit();
+        return false;
+    }
+
+    long frames = 0;
+    Coordinates none = {-1, -1};
+    double start = now(), seconds;
+    do
+    {
+        for (Level *level = levels; level != NULL; level = level->next)
+        {
+            Motion motion = {0, 0, {-1, -1}, 0, 0};
+            for (int i = 0; i < level->size.x * level->size.y; i++) // player is drawn separately from level
+            {
+                if (level->tiles[i] == playerS || level->tiles[i] == playerOnTargetS)
+                {
+                    motion.playerX = (float)(i % level->size.x);
+                    motion.playerY = (float)(i / level->size.x);
+                }
+            }
+            renderPlay(renderer, tiles, font, level, &motion, none, false);
+            frames++;
+        }
+        seconds = now() - start;
+    } while (seconds < MIN_SECONDS);
+    report("render_frame_us", seconds * 1e6 / frames, "us");
+
+    long texts = 0;
+    SDL_Color white = {255, 255, 255, 255};
+    start = now();
+    do
+    {
+        for (Level *level = levels; level != NULL; level = level->next)
+        {
+            renderFont(renderer, font, white, level->name, 10, 11, true, true);
+            texts++;
+        }
+        seconds = now() - start;
+    } while (seconds < MIN_SECONDS);
+    report("render_font_us", seconds * 1e6 / texts, "us");
+
+    TTF_CloseFont(font);
+    SDL_DestroyTexture(tiles);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    TTF_Quit();
+    SDL_Quit();
+    return true;
+}
+
+// Benchmark loader, move kernel, renderer and solver on level collections
+// Usage: bench [levels.xsb...], default collections are opened from the current directory
+// Results are printed as tab separated lines: name, value, unit
+// Moves and rendering use the first collection, solving uses all of them
+// Returns 0 if every benchmark could run
+int main(int argc, char **argv)
+{
+    char *defaults[] = {"p_easy.xsb", "p_hard.xsb", "p_boxes.xsb"};
+    char **files = argc > 1 ? argv + 1 : defaults;
+    int fileCount = argc > 1 ? argc - 1 : 3;
+
+    if (!benchFiles(files, fileCount))
+        return 1;
+    LoadLevelResult result = loadLevel(files[0]);
+    if (result.level == NULL)
+    {
+        fprintf(stderr, "ERROR: %s has no levels\n", files[0]);
+        return 1;
+    }
+    report("levels", countLevels(result.level), "levels");
+
+    benchMoves(result.level);
+    int status = 0;
+    if (!benchRender(result.level))
+    {
+        fprintf(stderr, "ERROR: Couldn't initialize SDL\n");
+        status = 1;
+    }
+    benchSolver(files, fileCount, 20000);
+
+    unloadLevel(result.level);
+    return status;
+}
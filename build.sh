@@ -1,13 +1,38 @@
 #!/bin/bash
 
+# quick unoptimized debug build, optimized builds are made with CMake:
+# cmake --preset release && cmake --build --preset release
+# other presets: debug, debugmalloc, pgo-generate (then: cmake --build build/pgo --target pgo-train), pgo-use
+
 # delete previous result
 # rm main
 
 # install sdl2
 # sudo apt install libsdl2-dev libsdl2-gfx-dev libsdl2-image-dev libsdl2-ttf-dev libsdl2-mixer-dev
 
+# install zlib for .gz collections, leave out -DSOKOBAN_ZLIB and -lz to build without it
+# sudo apt install zlib1g-dev
+
+# embed tiles.png and font.ttf into assets_data.c, every build of main needs it
+gcc tools/embed.c -o embed && ./embed assets_data.c tilesPng tiles.png fontTtf font.ttf
+
 # with debugmalloc
-# gcc -g *.c -o main `sdl2-config --cflags --libs` -DDEBUGMALLOC  -lSDL2_gfx -lSDL2_ttf -lSDL2_image -lSDL2_mixer 
+# gcc -g *.c -o main `sdl2-config --cflags --libs` -DDEBUGMALLOC -DSOKOBAN_ZLIB -lSDL2_gfx -lSDL2_ttf -lSDL2_image -lSDL2_mixer -lz
 
 # without debugmalloc
-gcc -g *.c -o main `sdl2-config --cflags --libs` -lSDL2_gfx -lSDL2_ttf -lSDL2_image -lSDL2_mixer 
\ No newline at end of file
+gcc -g *.c -o main `sdl2-config --cflags --libs` -DSOKOBAN_ZLIB -lSDL2_gfx -lSDL2_ttf -lSDL2_image -lSDL2_mixer -lz
+
+# solution verifier tool
+gcc -g -O2 tools/verify.c file.c import.c gzip.c move.c replay.c -o verify -DSOKOBAN_ZLIB -lz
+
+# level normalization and duplicate finder tool
+gcc -g -O2 tools/dedup.c canon.c file.c import.c gzip.c progress.c replay.c move.c -o dedup -DSOKOBAN_ZLIB -lz
+
+# solver tool, -d <directory> keeps positions in files for levels too large for memory
+gcc -g -O2 tools/solve.c solver.c spill.c path.c move.c replay.c file.c import.c gzip.c -o solve -DSOKOBAN_ZLIB -lz
+
+# level generator tool
+gcc -g -O2 tools/generate.c generator.c solver.c spill.c path.c move.c replay.c file.c import.c gzip.c -o generate -DSOKOBAN_ZLIB -lz -pthread
+
+# benchmarks, run from this directory: ./bench [levels.xsb...]
+gcc -g -O2 bench/bench.c `ls *.c | grep -v '^main.c$'` -o bench `sdl2-config --cflags --libs` -DSOKOBAN_ZLIB -lSDL2_ttf -lSDL2_image -lz -pthread
@@ -0,0 +1,259 @@
+#include "canon.h"
+#include "file.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+// Mark tiles that can be reached from the edge of the level without crossing walls
+// Outside floor is replaced by invalidS, outside crates, targets and player are kept
+// Returns false on memory allocation failure
+static bool clearOutside(TileState *tiles, int w, int h)
+{
+    int *queue = (int *)malloc(sizeof(int) * w * h);
+    bool *outside = (bool *)calloc(w * h, sizeof(bool));
+    if (queue == NULL || outside == NULL)
+    {
+        free(queue);
+        free(outside);
+        return false;
+    }
+    int head = 0, tail = 0;
+    for (int y = 0; y < h; y++) // start from every border tile
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int i = x + y * w;
+            if ((x == 0 || y == 0 || x == w - 1 || y == h - 1) && tiles[i] != wallS)
+            {
+                outside[i] = true;
+                queue[tail++] = i;
+            }
+        }
+    }
+    while (head < tail)
+    {
+        int i = queue[head++];
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int nx = i % w + dirX[dir], ny = i / w + dirY[dir];
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h)
+                continue;
+            int n = nx + ny * w;
+            if (!outside[n] && tiles[n] != wallS)
+            {
+                outside[n] = true;
+                queue[tail++] = n;
+            }
+        }
+    }
+    for (int i = 0; i < w * h; i++)
+    {
+        if (outside[i] && (tiles[i] == floorTileS || tiles[i] == invalidS))
+            tiles[i] = invalidS;
+    }
+    free(queue);
+    free(outside);
+    return true;
+}
+
+// Remove walls that do not touch any tile of the level, not even diagonally
+static void clearWalls(TileState *tiles, int w, int h)
+{
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            if (tiles[x + y * w] != wallS)
+                continue;
+            bool needed = false;
+            for (int j = y - 1; j <= y + 1 && !needed; j++)
+            {
+                for (int i = x - 1; i <= x + 1 && !needed; i++)
+                {
+                    if (i >= 0 && j >= 0 && i < w && j < h && tiles[i + j * w] != wallS && tiles[i + j * w] != invalidS)
+                        needed = true;
+                }
+            }
+            if (!needed)
+                tiles[x + y * w] = invalidS;
+        }
+    }
+}
+
+// Move player to the first tile in row order that it can walk to
+// Positions differing only in where the player stands in the same area are the same puzzle
+// Queue must hold w * h elements
+static void normalizePlayer(TileState *tiles, int w, int h, int *queue, bool *reached)
+{
+    int player = -1;
+    for (int i = 0; i < w * h; i++)
+    {
+        if (tiles[i] == playerS || tiles[i] == playerOnTargetS)
+        {
+            if (player != -1) // more players, nothing to normalize
+                return;
+            player = i;
+        }
+    }
+    if (player == -1)
+        return;
+
+    memset(reached, 0, sizeof(bool) * w * h);
+    int head = 0, tail = 0, first = player;
+    reached[player] = true;
+    queue[tail++] = player;
+    while (head < tail)
+    {
+        int i = queue[head++];
+        if (i < first)
+            first = i;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int nx = i % w + dirX[dir], ny = i / w + dirY[dir];
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h)
+                continue;
+            int n = nx + ny * w;
+            if (!reached[n] && (tiles[n] == floorTileS || tiles[n] == targetS))
+            {
+                reached[n] = true;
+                queue[tail++] = n;
+            }
+        }
+    }
+    tiles[player] = tiles[player] == playerOnTargetS ? targetS : floorTileS;
+    tiles[first] = tiles[first] == targetS ? playerOnTargetS : playerS;
+}
+
+// Returns true if candidate orientation comes before best one
+// Wide orientations come first, so a level that fits the screen still fits after normalization
+static bool betterOrientation(TileState *candidate, int cw, int ch, TileState *best, int bw, int bh)
+{
+    if ((cw >= ch) != (bw >= bh))
+        return cw >= ch;
+    if (cw != bw)
+        return cw < bw;
+    for (int i = 0; i < cw * ch; i++)
+    {
+        if (candidate[i] != best[i])
+            return candidate[i] < best[i];
+    }
+    return false;
+}
+
+// Create canonical form of level
+// Floor outside of walls and walls not touching the level become invalidS, the level is trimmed to its bounding box,
+// player is moved to the first tile of its area, and the first of the 8 rotations and mirrors is chosen
+// Equivalent levels have the same canonical form, so they can be compared with sameTiles or hashLevel
+// Name is copied, prev and next are NULL
+// Returns NULL on memory allocation failure
+Level *normalizeLevel(Level *level)
+{
+    int w = level->size.x, h = level->size.y;
+    TileState *tiles = (TileState *)malloc(sizeof(TileState) * w * h);
+    if (tiles == NULL)
+        return NULL;
+    memcpy(tiles, level->tiles, sizeof(TileState) * w * h);
+    if (!clearOutside(tiles, w, h))
+    {
+        free(tiles);
+        return NULL;
+    }
+    clearWalls(tiles, w, h);
+
+    int minX = w, minY = h, maxX = -1, maxY = -1; // bounding box of remaining tiles
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            if (tiles[x + y * w] == invalidS)
+                continue;
+            minX = x < minX ? x : minX;
+            minY = y < minY ? y : minY;
+            maxX = x > maxX ? x : maxX;
+            maxY = y > maxY ? y : maxY;
+        }
+    }
+    if (maxX == -1) // nothing left, keep whole level
+    {
+        minX = minY = 0;
+        maxX = w - 1;
+        maxY = h - 1;
+    }
+    int boxW = maxX - minX + 1, boxH = maxY - minY + 1;
+
+    Level *result = (Level *)malloc(sizeof(Level));
+    TileState *best = (TileState *)malloc(sizeof(TileState) * boxW * boxH);
+    TileState *candidate = (TileState *)malloc(sizeof(TileState) * boxW * boxH);
+    int *queue = (int *)malloc(sizeof(int) * boxW * boxH);
+    bool *reached = (bool *)malloc(sizeof(bool) * boxW * boxH);
+    char *name = (char *)malloc(strlen(level->name) + 1);
+    if (result == NULL || best == NULL || candidate == NULL || queue == NULL || reached == NULL || name == NULL)
+    {
+        free(tiles);
+        free(result);
+        free(best);
+        free(candidate);
+        free(queue);
+        free(reached);
+        free(name);
+        return NULL;
+    }
+
+    int bestW = 0, bestH = 0;
+    for (int t = 0; t < 8; t++) // bit 0: mirror horizontally, bit 1: mirror vertically, bit 2: transpose
+    {
+        int cw = t & 4 ? boxH : boxW;
+        int ch = t & 4 ? boxW : boxH;
+        for (int y = 0; y < ch; y++)
+        {
+            for (int x = 0; x < cw; x++)
+            {
+                int u = t & 4 ? y : x;
+                int v = t & 4 ? x : y;
+                if (t & 1)
+                    u = boxW - 1 - u;
+                if (t & 2)
+                    v = boxH - 1 - v;
+                candidate[x + y * cw] = tiles[minX + u + (minY + v) * w];
+            }
+        }
+        normalizePlayer(candidate, cw, ch, queue, reached);
+        if (t == 0 || betterOrientation(candidate, cw, ch, best, bestW, bestH))
+        {
+            TileState *swap = best;
+            best = candidate;
+            candidate = swap;
+            bestW = cw;
+            bestH = ch;
+        }
+    }
+
+    strcpy(name, level->name);
+    result->size.x = bestW;
+    result->size.y = bestH;
+    result->tiles = best;
+    result->name = name;
+    result->prev = NULL;
+    result->next = NULL;
+    free(tiles);
+    free(candidate);
+    free(queue);
+    free(reached);
+    return result;
+}
+
+// Returns true if levels have the same size and tiles
+bool sameTiles(Level *a, Level *b)
+{
+    if (a->size.x != b->size.x || a->size.y != b->size.y)
+        return false;
+    return memcmp(a->tiles, b->tiles, sizeof(TileState) * a->size.x * a->size.y) == 0;
+}
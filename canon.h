@@ -0,0 +1,10 @@
+#ifndef CANON_H
+#define CANON_H
+
+#include <stdbool.h>
+#include "file.h"
+
+Level *normalizeLevel(Level *level);
+bool sameTiles(Level *a, Level *b);
+
+#endif
@@ -0,0 +1,142 @@
+#include "check.h"
+#include "file.h"
+#include "solver.h"
+#include "coordinates.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Count players, crates and targets of level
+static void countTiles(Level *level, LevelCheck *check)
+{
+    check->players = 0;
+    check->crates = 0;
+    check->targets = 0;
+    for (int i = 0; i < level->size.x * level->size.y; i++)
+    {
+        if (level->tiles[i] == playerS || level->tiles[i] == playerOnTargetS)
+        {
+            check->players++;
+        }
+        if (level->tiles[i] == crateS || level->tiles[i] == crateOnTargetS)
+        {
+            check->crates++;
+        }
+        if (level->tiles[i] == targetS || level->tiles[i] == crateOnTargetS || level->tiles[i] == playerOnTargetS)
+        {
+            check->targets++;
+        }
+    }
+    check->valid = check->players == 1 && check->crates >= check->targets;
+}
+
+// Check number of players and crate count and target count relation
+// Returns true if level can be played
+bool validLevel(Level *level)
+{
+    LevelCheck check;
+    countTiles(level, &check);
+    return check.valid;
+}
+
+// Check if player can reach every crate and target when crates are not in the way
+// Level must have exactly one player
+// Returns false on memory allocation failure too
+static bool checkReachable(Level *level)
+{
+    int count = level->size.x * level->size.y;
+    int *queue = (int *)malloc(sizeof(int) * count);
+    bool *reached = (bool *)calloc(count, sizeof(bool));
+    if (queue == NULL || reached == NULL)
+    {
+        free(queue);
+        free(reached);
+        return false;
+    }
+
+    int head = 0;
+    int tail = 0;
+    for (int i = 0; i < count; i++) // start from player
+    {
+        if (level->tiles[i] == playerS || level->tiles[i] == playerOnTargetS)
+        {
+            queue[tail++] = i;
+            reached[i] = true;
+        }
+    }
+    while (head < tail)
+    {
+        int x = queue[head] % level->size.x;
+        int y = queue[head] / level->size.x;
+        head++;
+        Coordinates neighbours[4] = {{x - 1, y}, {x, y - 1}, {x + 1, y}, {x, y + 1}};
+        for (int i = 0; i < 4; i++)
+        {
+            int nx = neighbours[i].x;
+            int ny = neighbours[i].y;
+            if (nx < 0 || ny < 0 || nx >= level->size.x || ny >= level->size.y)
+                continue;
+            TileState tile = level->tiles[nx + ny * level->size.x];
+            if (tile != wallS && tile != invalidS && !reached[nx + ny * level->size.x])
+            {
+                reached[nx + ny * level->size.x] = true;
+                queue[tail++] = nx + ny * level->size.x;
+            }
+        }
+    }
+
+    bool result = true;
+    for (int i = 0; i < count; i++)
+    {
+        TileState tile = level->tiles[i];
+        if ((tile == crateS || tile == crateOnTargetS || tile == targetS) && !reached[i])
+            result = false;
+    }
+    free(queue);
+    free(reached);
+    return result;
+}
+
+// Count crates that are already in a dead position
+// Returns -1 on memory allocation failure
+static int countDeadCrates(Level *level)
+{
+    int count = level->size.x * level->size.y;
+    bool *live = (bool *)malloc(sizeof(bool) * count);
+    if (live == NULL || !findLiveTiles(level, live))
+    {
+        free(live);
+        return -1;
+    }
+
+    int dead = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (level->tiles[i] == crateS && !live[i])
+            dead++;
+    }
+    free(live);
+    return dead;
+}
+
+// Check level for common mistakes of level design
+// Reachability and dead crates are only checked for valid levels,
+// dead crates only if there are as many crates as targets, otherwise surplus crates can stay anywhere
+LevelCheck checkLevel(Level *level)
+{
+    LevelCheck check;
+    countTiles(level, &check);
+    check.reachable = false;
+    check.deadCrates = -1;
+    if (check.valid)
+    {
+        check.reachable = checkReachable(level);
+        if (check.crates == check.targets)
+            check.deadCrates = countDeadCrates(level);
+    }
+    return check;
+}
@@ -0,0 +1,20 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdbool.h>
+#include "file.h"
+
+typedef struct LevelCheck
+{
+    int players;
+    int crates;
+    int targets;
+    bool valid;     // exactly one player and at least as many crates as targets
+    bool reachable; // player can reach every crate and target if crates are not in the way
+    int deadCrates; // crates on tiles from where they can never reach a target, -1 if not checked or crates outnumber targets
+} LevelCheck;
+
+bool validLevel(Level *level);
+LevelCheck checkLevel(Level *level);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef CORE_H
+#define CORE_H
+
+// Game engine without SDL, built as the sokoban_core library
+// Front ends, tools and benchmarks include this header and link only the engine
+
+#include "coordinates.h"
+#include "file.h"
+#include "move.h"
+#include "replay.h"
+#include "game.h"
+#include "path.h"
+#include "progress.h"
+#include "history.h"
+#include "check.h"
+#include "solver.h"
+#include "canon.h"
+#include "generator.h"
+
+#endif
@@ -3,6 +3,12 @@
 #include "input.h"
 #include "coordinates.h"
 #include "tiles.h"
+#include "stats.h"
+#include "history.h"
+#include "livecheck.h"
+#include "preload.h"
+#include "picker.h"
+#include "levelindex.h"
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -22,6 +28,13 @@ typedef struct EditState
     int result;
     bool ctrl;
     bool unsaved;
+    History history;  // undo and redo of changes
+    Coordinates mark; // other corner of area tools, x is -1 if not set
+    Level *clipboard; // copied area, name is not used
+    LiveCheck *live;        // background check of current level, NULL if thread could not be started
+    bool recheck;           // current level was changed or switched since last check request
+    Thumbnails *thumbnails; // previews of level picker, started when picker is first opened
+    char query[64];         // last search, offered again to find the next match
     char *filename;
     SDL_Renderer *renderer;
     SDL_Texture *tiles;
@@ -52,7 +65,6 @@ static Tile tileStateToTile(TileState state)
         return brownFloor;
     }
 }
-/*
 // Get tile at coordinates
 // Returns invalidS for tiles outside of play area
 static TileState getTileState(Level *level, int x, int y)
@@ -62,7 +74,7 @@ static TileState getTileState(Level *level, int x, int y)
         return invalidS;
     }
     return level->tiles[x + y * level->size.x];
-}*/
+}
 
 // Set state of tile at coordinates
 // Does nothing for tiles outside of play area
@@ -75,6 +87,43 @@ static void setTileState(Level *level, int x, int y, TileState state)
     level->tiles[x + y * level->size.x] = state;
 }
 
+// Render result of background check of current level to top of screen
+static void renderLiveResult(EditState *state)
+{
+    if (state->live == NULL)
+        return;
+    LiveResult live = getLiveResult(state->live);
+    char text[64];
+    if (!live.done)
+        sprintf(text, "Ellenőrzés...");
+    else if (live.check.players != 1)
+        sprintf(text, "Hiba: %d játékos", live.check.players);
+    else if (!live.check.valid)
+        sprintf(text, "Hiba: kevesebb láda, mint cél");
+    else if (!live.check.reachable)
+        sprintf(text, "Hiba: elérhetetlen láda vagy cél");
+    else if (live.check.deadCrates > 0)
+        sprintf(text, "Holtpont: %d láda", live.check.deadCrates);
+    else if (live.solve == 0)
+        sprintf(text, "Megoldható: %d tolás", live.pushes);
+    else if (live.solve == 1)
+        sprintf(text, "Nem megoldható");
+    else
+        sprintf(text, "Nem dőlt el időben");
+
+    SDL_Rect background = {3 * 64, 12, 14 * 64, 40}; // translucent strip, so level stays visible below
+    SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(state->renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(state->renderer, &background);
+    SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(state->renderer, 0, 0, 0, 255);
+
+    SDL_Color color = {255, 255, 255, 255};
+    if (live.done && live.solve != 0)
+        color = (SDL_Color){255, 200, 80, 255}; // highlight anything that needs attention
+    renderFont(state->renderer, state->font, color, text, 10, 0, true, true);
+}
+
 // Render current state of play to renderer
 // State must include proper renderer, tiles, and font
 static void render(EditState *state)
@@ -123,8 +172,10 @@ static void render(EditState *state)
             }
         }
 
-        // render selection
+        // render selection and mark of area tools
         renderTile(renderer, tiles, selection, state->edit.x + startX, state->edit.y + startY);
+        if (state->mark.x != -1)
+            renderTile(renderer, tiles, selection, state->mark.x + startX, state->mark.y + startY);
 
         if (state->level->prev != NULL) // prevoius button is previous level exists
             renderTile(renderer, tiles, left, 0, 11);
@@ -132,9 +183,11 @@ static void render(EditState *state)
         if (state->level->next != NULL)                                     // next button in next level exists
             renderTile(renderer, tiles, right, 19, 11);
         renderTile(renderer, tiles, delete, 0, 10);
+        renderTile(renderer, tiles, levels, 0, 9);
+        renderLiveResult(state);
     }
 
-    SDL_RenderPresent(renderer); // render creation
+    presentFrame(renderer); // render creation
 }
 
 // Save current levels to file
@@ -151,7 +204,7 @@ static void saveState(EditState *state)
     if (result == 2)
         return;
 
-    bool saveSuccess = saveLevel(state->firstLevel, state->filename);
+    bool saveSuccess = saveLevel(state->firstLevel, state->filename, false);
     if (saveSuccess)
     {
         state->unsaved = false;
@@ -276,6 +329,10 @@ static void addLevel(EditState *state, bool dir)
     state->unsaved = true;   // modified file
     state->edit.x = 0;       // set selection
     state->edit.y = 0;
+    state->mark.x = -1;
+    state->mark.y = -1;
+    recordInsert(&state->history, newLevel);
+    state->recheck = true;
 }
 
 // Paprikás krumplit főz
@@ -296,42 +353,13 @@ static void deleteCurrent(EditState *state)
     state->unsaved = true;
     state->edit.x = 0;
     state->edit.y = 0;
-    if (state->level->prev == NULL && state->level->next == NULL)
-    {
-        free(state->level->tiles);
-        free(state->level->name);
-        free(state->level);
-        state->level = NULL;
-        state->firstLevel = NULL;
-        return;
-    }
-    if (state->level->prev == NULL)
-    {
-        state->firstLevel = state->level->next;
-        state->firstLevel->prev = NULL;
-        free(state->level->tiles);
-        free(state->level->name);
-        free(state->level);
-        state->level = state->firstLevel;
-        return;
-    }
-    if (state->level->next == NULL)
-    {
-        state->level->prev->next = NULL;
-        Level *prev = state->level->prev;
-        free(state->level->tiles);
-        free(state->level->name);
-        free(state->level);
-        state->level = prev;
-        return;
-    }
-    state->level->prev->next = state->level->next;
-    state->level->next->prev = state->level->prev;
-    Level *next = state->level->next;
-    free(state->level->tiles);
-    free(state->level->name);
-    free(state->level);
-    state->level = next;
+    state->mark.x = -1; // mark belongs to previous level
+    state->mark.y = -1;
+    Level *level = state->level;
+    state->level = level->next != NULL ? level->next : level->prev; // show next level, or previous if deleting last one
+    unlinkLevel(&state->firstLevel, level);
+    recordDelete(&state->history, level); // level is freed by history when it cannot be undone anymore
+    state->recheck = true;
 }
 
 // Swtiches to next level if possible
@@ -342,6 +370,9 @@ static void nextLevel(EditState *state)
     state->level = state->level->next;
     state->edit.x = 0;
     state->edit.y = 0;
+    state->mark.x = -1; // mark belongs to previous level
+    state->mark.y = -1;
+    state->recheck = true;
 }
 
 // Swtiches to prevoius level if possible
@@ -352,6 +383,69 @@ static void prevLevel(EditState *state)
     state->level = state->level->prev;
     state->edit.x = 0;
     state->edit.y = 0;
+    state->mark.x = -1; // mark belongs to previous level
+    state->mark.y = -1;
+    state->recheck = true;
+}
+
+// Show level picker and switch to chosen level
+static void pickCurrent(EditState *state)
+{
+    if (state->level == NULL)
+        return;
+    if (state->thumbnails == NULL)
+        state->thumbnails = startThumbnails(state->renderer);
+    else
+        clearThumbnails(state->thumbnails); // levels may have been edited since picker was last open
+    Level *picked = state->level;
+    int result = pickLevel(state->renderer, state->tiles, state->font, state->thumbnails, state->firstLevel, &picked);
+    if (result == 0)
+        state->result = 0;
+    if (result != 1 || picked == state->level)
+        return;
+    state->level = picked;
+    state->edit.x = 0;
+    state->edit.y = 0;
+    state->mark.x = -1; // mark belongs to previous level
+    state->mark.y = -1;
+    state->recheck = true;
+}
+
+// Ask user for search query and switch to next level matching it
+// Index is built for every search, as levels may have been edited since the last one
+static void searchLevel(EditState *state)
+{
+    if (state->level == NULL)
+        return;
+    int result = textInput(state->renderer, state->tiles, state->font, "Keresés (név, láda>8)", state->query, 63);
+    if (result != 1)
+    {
+        if (result == 0)
+            state->result = 0;
+        return;
+    }
+    LevelIndex index;
+    int found = -3;
+    if (buildIndex(&index, state->firstLevel))
+        found = searchIndex(&index, state->query, findEntry(&index, state->level));
+    Level *level = found < 0 ? NULL : index.entries[found].level;
+    freeIndex(&index);
+
+    char *message = found == -1 ? "Nincs találat" : found == -2 ? "Hibás keresés" : "Memóriafoglalási hiba";
+    if (found < 0)
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, message) == 0)
+            state->result = 0;
+        return;
+    }
+    if (level == state->level)
+        return;
+    state->level = level;
+    state->edit.x = 0;
+    state->edit.y = 0;
+    state->mark.x = -1; // mark belongs to previous level
+    state->mark.y = -1;
+    state->recheck = true;
 }
 
 // Exit to main menu
@@ -416,14 +510,169 @@ static bool moveSelection(int dir, EditState *state)
     }
 }
 
+// Set tile of current level and record change for undo
+// Does nothing for tiles outside of play area
+static void paintTile(EditState *state, int x, int y, TileState tile)
+{
+    TileState before = getTileState(state->level, x, y);
+    if (before == invalidS || tile == invalidS || before == tile) // outside of level or nothing changes
+        return;
+    state->unsaved = true;
+    setTileState(state->level, x, y, tile);
+    recordTile(&state->history, state->level, x + y * state->level->size.x, before, tile);
+    state->recheck = true;
+}
+
 // Set tile on edit coordinates to selected tile
 static void modifyTile(EditState *state)
 {
     if (state->edit.x >= 0 && state->edit.x < state->level->size.x && state->edit.y >= 0 && state->edit.y < state->level->size.y)
     {
-        state->unsaved = true;
-        setTileState(state->level, state->edit.x, state->edit.y, state->selection + 1);
+        paintTile(state, state->edit.x, state->edit.y, state->selection + 1);
+    }
+}
+
+// Set or remove mark on edit coordinates
+// Mark and edit coordinates are the corners of area for fill and copy
+static void toggleMark(EditState *state)
+{
+    if (state->mark.x == state->edit.x && state->mark.y == state->edit.y)
+    {
+        state->mark.x = -1;
+        state->mark.y = -1;
     }
+    else
+        state->mark = state->edit;
+}
+
+// Get area between mark and edit coordinates, both corners are inclusive
+// Area is the single edited tile if there is no mark
+static void getArea(EditState *state, Coordinates *from, Coordinates *to)
+{
+    *from = state->edit;
+    *to = state->edit;
+    if (state->mark.x == -1)
+        return;
+    if (state->mark.x < from->x)
+        from->x = state->mark.x;
+    else
+        to->x = state->mark.x;
+    if (state->mark.y < from->y)
+        from->y = state->mark.y;
+    else
+        to->y = state->mark.y;
+}
+
+// Fill area between mark and edit coordinates with selected tile
+// Fill is a single step for undo
+static void fillArea(EditState *state)
+{
+    Coordinates from, to;
+    getArea(state, &from, &to);
+    beginGroup(&state->history);
+    for (int j = from.y; j <= to.y; j++)
+    {
+        for (int i = from.x; i <= to.x; i++)
+            paintTile(state, i, j, state->selection + 1);
+    }
+    endGroup(&state->history);
+    state->mark.x = -1; // area is used up
+    state->mark.y = -1;
+}
+
+// Replace connected tiles of the same kind as the edited tile with selected tile
+// Fill is a single step for undo
+static void floodFill(EditState *state)
+{
+    Level *level = state->level;
+    TileState from = getTileState(level, state->edit.x, state->edit.y);
+    TileState to = state->selection + 1;
+    if (from == invalidS || from == to)
+        return;
+
+    int *queue = (int *)malloc(sizeof(int) * level->size.x * level->size.y); // every tile is queued at most once
+    if (queue == NULL)
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, "Memóriafoglalási hiba") == 0)
+            state->result = 0;
+        return;
+    }
+
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = state->edit.x + state->edit.y * level->size.x;
+    beginGroup(&state->history);
+    paintTile(state, state->edit.x, state->edit.y, to);
+    while (head < tail)
+    {
+        int x = queue[head] % level->size.x;
+        int y = queue[head] / level->size.x;
+        head++;
+        Coordinates neighbours[4] = {{x - 1, y}, {x, y - 1}, {x + 1, y}, {x, y + 1}};
+        for (int i = 0; i < 4; i++)
+        {
+            if (getTileState(level, neighbours[i].x, neighbours[i].y) == from) // painted tiles are not visited again
+            {
+                paintTile(state, neighbours[i].x, neighbours[i].y, to);
+                queue[tail++] = neighbours[i].x + neighbours[i].y * level->size.x;
+            }
+        }
+    }
+    endGroup(&state->history);
+    free(queue);
+}
+
+// Copy area between mark and edit coordinates to clipboard
+// Clipboard is kept between levels
+static void copyArea(EditState *state)
+{
+    Coordinates from, to;
+    getArea(state, &from, &to);
+    Level *clipboard = (Level *)malloc(sizeof(Level));
+    if (clipboard != NULL)
+    {
+        clipboard->size.x = to.x - from.x + 1;
+        clipboard->size.y = to.y - from.y + 1;
+        clipboard->name = NULL;
+        clipboard->tiles = (TileState *)malloc(sizeof(TileState) * clipboard->size.x * clipboard->size.y);
+        if (clipboard->tiles == NULL)
+        {
+            free(clipboard);
+            clipboard = NULL;
+        }
+    }
+    if (clipboard == NULL)
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, "Memóriafoglalási hiba") == 0)
+            state->result = 0;
+        return;
+    }
+
+    for (int j = 0; j < clipboard->size.y; j++)
+    {
+        for (int i = 0; i < clipboard->size.x; i++)
+            clipboard->tiles[i + j * clipboard->size.x] = getTileState(state->level, from.x + i, from.y + j);
+    }
+    freeLevel(state->clipboard);
+    state->clipboard = clipboard;
+    state->mark.x = -1; // area is used up
+    state->mark.y = -1;
+}
+
+// Paste clipboard with its top left corner on edit coordinates
+// Tiles outside of level are left out, paste is a single step for undo
+static void pasteArea(EditState *state)
+{
+    Level *clipboard = state->clipboard;
+    if (clipboard == NULL)
+        return;
+    beginGroup(&state->history);
+    for (int j = 0; j < clipboard->size.y; j++)
+    {
+        for (int i = 0; i < clipboard->size.x; i++)
+            paintTile(state, state->edit.x + i, state->edit.y + j, clipboard->tiles[i + j * clipboard->size.x]);
+    }
+    endGroup(&state->history);
 }
 
 // Rename current level
@@ -442,11 +691,46 @@ static void renameLevel(EditState *state)
             state->result = 0;
         return;
     }
-    free(state->level->name);
     int len = strlen(name);
-    state->level->name = (char *)malloc((len + 1) * sizeof(char));
-    strcpy(state->level->name, name);
+    char *newName = (char *)malloc((len + 1) * sizeof(char));
+    if (newName == NULL)
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, "Memóriafoglalási hiba") == 0)
+            state->result = 0;
+        return;
+    }
+    strcpy(newName, name);
+    char *oldName = state->level->name;
+    state->level->name = newName;
+    recordRename(&state->history, state->level, oldName); // old name is kept for undo
+    state->unsaved = true;
+}
+
+// Undo or redo last change of levels
+// Shows level and tile affected by the change
+// Undo: true to undo, false to redo
+// Returns true if rerender is needed
+static bool undoRedo(EditState *state, bool undo)
+{
+    Change *change = undo ? undoChange(&state->history, &state->firstLevel) : redoChange(&state->history, &state->firstLevel);
+    if (change == NULL)
+        return false;
+
     state->unsaved = true;
+    state->edit.x = 0;
+    state->edit.y = 0;
+    state->mark.x = -1; // mark belongs to previous level
+    state->mark.y = -1;
+    state->level = change->level;
+    if (change->type == tileC) // move selection to changed tile
+    {
+        state->edit.x = change->index % change->level->size.x;
+        state->edit.y = change->index / change->level->size.x;
+    }
+    if ((change->type == insertC && undo) || (change->type == deleteC && !undo)) // level is not in the list anymore
+        state->level = change->level->next != NULL ? change->level->next : change->level->prev;
+    state->recheck = true;
+    return true;
 }
 
 // Handle SDL key down event
@@ -498,6 +782,11 @@ static bool handleKeydown(EditState *state, SDL_Scancode key)
     case 0xe4: // right ctrl
         state->ctrl = true;
         return false;
+    case 0x2b: // tab
+        if (state->ctrl)
+            return false;
+        pickCurrent(state);
+        return true;
     case 0x4c: // delete
         if (state->ctrl)
             return false;
@@ -518,6 +807,45 @@ static bool handleKeydown(EditState *state, SDL_Scancode key)
             return false;
         renameLevel(state);
         return true;
+    case 0x1c: // letter z
+        if (!state->ctrl)
+            return false;
+        return undoRedo(state, true);
+    case 0x14: // letter q
+        if (state->ctrl || state->level == NULL)
+            return false;
+        toggleMark(state);
+        return true;
+    case 0x08: // letter e
+        if (state->ctrl || state->level == NULL)
+            return false;
+        fillArea(state);
+        return true;
+    case 0x09: // letter f
+        if (state->level == NULL)
+            return false;
+        if (state->ctrl)
+        {
+            searchLevel(state);
+            state->ctrl = false;
+            return true;
+        }
+        floodFill(state);
+        return true;
+    case 0x06: // letter c
+        if (!state->ctrl || state->level == NULL)
+            return false;
+        copyArea(state);
+        return true;
+    case 0x19: // letter v
+        if (!state->ctrl || state->level == NULL)
+            return false;
+        pasteArea(state);
+        return true;
+    case 0x1d: // letter y
+        if (!state->ctrl)
+            return false;
+        return undoRedo(state, false);
     case 0x28: // enter
     case 0x2c: // spacebar
         if (state->ctrl)
@@ -619,6 +947,11 @@ static bool handleClick(EditState *state, int x, int y)
         deleteCurrent(state);
         return true;
     }
+    if (clickTile(0, 9, x, y)) // level picker
+    {
+        pickCurrent(state);
+        return true;
+    }
     if (state->level != NULL)
     {
         for (int i = 0; i < 7; i++)
@@ -655,6 +988,22 @@ static bool handleClick(EditState *state, int x, int y)
     return false;
 }
 
+// Handle SDL right mouse click
+// Right click on level sets mark of area tools
+// Returns true if rerender is needed
+static bool handleRightClick(EditState *state, int x, int y)
+{
+    if (state->level == NULL)
+        return false;
+    int startX = 1 + (19 - state->level->size.x) / 2;
+    int startY = 0 + (11 - state->level->size.y) / 2;
+    if (!clickTiles(startX, startY, startX + state->level->size.x - 1, startY + state->level->size.y - 1, x, y))
+        return false;
+    state->mark.x = x / 64 - startX;
+    state->mark.y = y / 64 - startY;
+    return true;
+}
+
 // Handles SDL event
 // Returns true if rerender is needed
 static bool handleEvent(SDL_Event event, EditState *state)
@@ -666,12 +1015,14 @@ static bool handleEvent(SDL_Event event, EditState *state)
     case SDL_KEYUP:
         return handleKeyup(state, event.key.keysym.scancode);
     case SDL_MOUSEBUTTONDOWN:
+        if (event.button.button == SDL_BUTTON_RIGHT)
+            return handleRightClick(state, event.button.x, event.button.y);
         return handleClick(state, event.button.x, event.button.y);
     case SDL_QUIT: // exit program
         state->result = 0;
         return false;
     default:
-        return false;
+        return event.type == liveCheckEvent(state->live); // result of background check arrived
         break;
     }
 }
@@ -680,7 +1031,7 @@ static bool handleEvent(SDL_Event event, EditState *state)
 // Returns 0 on SDL_Quit, 1 on exit to menu
 int editLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *filename)
 {
-    LoadLevelResult result = loadLevel(filename);
+    LoadLevelResult result = openLevels(filename); // collection may have been parsed during startup
     switch (result.result)
     {
     case 2:
@@ -725,7 +1076,16 @@ int editLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *
     state.edit.x = 0;
     state.edit.y = 0;
     state.selection = 0;
+    state.mark.x = -1;
+    state.mark.y = -1;
+    state.clipboard = NULL;
+    initHistory(&state.history, 16384, 4 * 1024 * 1024); // without history changes simply cannot be undone
+    state.live = startLiveCheck(2.0);                     // editor works without checking too
+    state.recheck = false;
+    state.thumbnails = NULL;
+    state.query[0] = '\0';
 
+    requestLiveCheck(state.live, state.level);
     render(&state);
 
     SDL_Event ev;
@@ -734,9 +1094,19 @@ int editLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *
         bool rerender = handleEvent(ev, &state);
         if (state.result != -1) // if result was set
         {
+            stopLiveCheck(state.live); // worker must not use levels anymore
+            stopThumbnails(state.thumbnails);
             unloadLevel(state.firstLevel);
+            freeHistory(&state.history);
+            freeLevel(state.clipboard);
             return state.result; // return to main
         }
+        if (state.recheck) // check changed level in background
+        {
+            requestLiveCheck(state.live, state.level);
+            state.recheck = false;
+            rerender = true;
+        }
         if (rerender) // if rerender is needed
             render(&state);
     }
@@ -1,23 +1,19 @@
 #include "file.h"
+#include "import.h"
+#include "gzip.h"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #ifdef DEBUGMALLOC
 #include "debugmalloc.h"
 #endif
 
-typedef struct LoadState
-{
-    char line[64];
-    int lineLength;
-    char name[64];
-    TileState level[209]; // 11 x 19 squares
-    int rowIndex;
-    int maxLength;
-} LoadState;
+#define LINE_SIZE 256 // run length encoded lines can hold a whole level, longer lines are cut
 
 // Check if given character is a valig sokoban tile
 // Returns true if valid
@@ -84,184 +80,307 @@ static char tileToChar(TileState tile)
     }
 }
 
-// Fill entire level with floor tiles, except first one
-// First tile is invalidS
+// Fill entire level with floor tiles
 static void emptyLevel(TileState *level)
 {
-    level[0] = '\0';
-    for (int i = 1; i < 209; i++)
+    for (int i = 0; i < 209; i++)
     {
         level[i] = floorTileS;
     }
 }
 
-// Add level to current linked list
-// If level is too large, nothing will be saved and will result in success
-// Returns 2 on faliure, 0 on success
-static int addLevel(LoadState *state, Level **first, Level **current)
+// Reset builder for next level, finished levels are kept
+static void clearBuilder(LevelBuilder *builder)
 {
-    if (state->maxLength <= 19 && state->rowIndex <= 11) // if level is not too large
+    emptyLevel(builder->tiles);
+    builder->name[0] = '\0';
+    builder->rows = 0;
+    builder->width = 0;
+    builder->tooLarge = false;
+}
+
+// Start building a list of levels
+void initBuilder(LevelBuilder *builder)
+{
+    builder->first = NULL;
+    builder->last = NULL;
+    clearBuilder(builder);
+}
+
+// Check if level being built has rows, including rows that did not fit
+bool hasRows(LevelBuilder *builder)
+{
+    return builder->rows > 0 || builder->tooLarge;
+}
+
+// Add row of level being built
+// Row: characters of XSB format, not terminated, length: number of characters
+// Rows not fitting into 19 x 11 are not stored, level is marked as too large instead
+// Returns false if row contains an invalid character
+bool addRow(LevelBuilder *builder, char *row, int length)
+{
+    if (length > builder->width) // track maximum line length
+        builder->width = length;
+    if (length > 19 || builder->rows >= 11) // size is over limits
     {
-        if (*first == NULL) // if linked list is empty
-        {
-            *first = *current = (Level *)malloc(sizeof(Level)); // allocate memory for first element
-            if (current == NULL)                                // if failed, return and free memory
-            {
-                unloadLevel(*first);
-                return 2;
-            }
-            (*current)->prev = NULL; // set next and prev to null
-            (*current)->next = NULL;
-        }
-        else
-        {
-            Level *new = (Level *)malloc(sizeof(Level)); // allocate memory for new element
-            if (new == NULL)                             // if failed, return and free memory
-            {
-                unloadLevel(*first);
-                return 2;
-            }
-            (*current)->next = new; // appent to current list
-            new->prev = *current;   // also do it backwards
-            new->next = NULL;       // this is the last element
-            *current = new;         // make the new element the current element
-        }
+        builder->tooLarge = true;
+        return true;
+    }
+
+    for (int i = 0; i < length; i++) // copy each tile while checking if valid
+    {
+        if (!checkTile(row[i]))
+            return false;
+        builder->tiles[i + 19 * builder->rows] = charToTile(row[i]);
+    }
+    builder->rows++; // move to next row
+    return true;
+}
 
-        (*current)->size.x = state->maxLength; // set sizes
-        (*current)->size.y = state->rowIndex;
-        (*current)->tiles = (TileState *)malloc(sizeof(TileState) * (state->maxLength * state->rowIndex)); // allocate memory for tiles
-        if ((*current)->tiles == NULL)                                                                     // if failed, return and free memory
+// Check if line is a run length encoded row, like 4#2-$.# or 5#|#@$.#
+// Such rows may start with a digit or -, and always contain a wall
+static bool isRleRow(char *line)
+{
+    if (strchr(line, '#') == NULL)
+        return false;
+    for (char *c = line; *c != '\0'; c++)
+    {
+        if (strchr("#@+$*. -_0123456789|", *c) == NULL)
+            return false;
+    }
+    return true;
+}
+
+// Add rows of a line that may be run length encoded
+// Digits repeat the following tile, | separates rows, - and _ are floor
+// Lines without digits and | are added as a single row
+// Returns false if a row contains an invalid character
+bool addRleRows(LevelBuilder *builder, char *line)
+{
+    char row[64];
+    int length = 0;
+    int count = 0;
+    for (char *c = line;; c++)
+    {
+        if (*c >= '0' && *c <= '9')
         {
-            unloadLevel(*first);
-            return 2;
+            if (count < 64)
+                count = count * 10 + (*c - '0');
+            continue;
         }
-        (*current)->name = (char *)malloc(sizeof(char) * (strlen(state->name) + 1)); // allocate memory for name
-        if ((*current)->name == NULL)                                                // if failed, return and free memory
+        if (*c == '|' || *c == '\0')
         {
-            unloadLevel(*first);
-            return 2;
+            if (!addRow(builder, row, length))
+                return false;
+            if (*c == '\0')
+                return true;
+            length = 0;
+            continue;
         }
+        char tile = *c == '-' || *c == '_' ? ' ' : *c;
+        for (int i = 0; i < (count == 0 ? 1 : count); i++) // tiles that do not fit make the level too large
+            row[length < 64 ? length++ : 63] = tile;
+        count = 0;
+    }
+}
+
+// Add level being built to linked list and start next level
+// If level is too large, nothing will be saved
+// Returns 0 on success, 2 on memory allocation faliure (list is freed), 4 if level was too large
+int finishLevel(LevelBuilder *builder)
+{
+    if (builder->tooLarge)
+    {
+        clearBuilder(builder);
+        return 4;
+    }
 
-        strcpy((*current)->name, state->name); // copy name
+    Level *new = (Level *)malloc(sizeof(Level)); // allocate memory for new element
+    if (new == NULL)                             // if failed, return and free memory
+    {
+        unloadLevel(builder->first);
+        builder->first = NULL;
+        return 2;
+    }
+    new->size.x = builder->width; // set sizes
+    new->size.y = builder->rows;
+    new->tiles = (TileState *)malloc(sizeof(TileState) * (builder->width * builder->rows)); // allocate memory for tiles
+    new->name = (char *)malloc(sizeof(char) * (strlen(builder->name) + 1));                 // allocate memory for name
+    if (new->tiles == NULL || new->name == NULL)                                            // if failed, return and free memory
+    {
+        freeLevel(new);
+        unloadLevel(builder->first);
+        builder->first = NULL;
+        return 2;
+    }
+    strcpy(new->name, builder->name); // copy name
 
-        for (int i = 0; i < state->rowIndex; i++) // copy tiles to new place
+    for (int i = 0; i < builder->rows; i++) // copy tiles to new place
+    {
+        for (int j = 0; j < builder->width; j++)
         {
-            for (int j = 0; j < state->maxLength; j++)
-            {
-                // state level storage is 19 x 11, but the new level storage is only as big as big as it needs to be
-                // so cannot use memcpy
-                (*current)->tiles[j + state->maxLength * i] = state->level[j + 19 * i];
-            }
+            // builder storage is 19 x 11, but the new level storage is only as big as big as it needs to be
+            // so cannot use memcpy
+            new->tiles[j + builder->width * i] = builder->tiles[j + 19 * i];
         }
     }
 
-    emptyLevel(state->level); // empty current level
-    state->name[0] = 0;       // set variables to inital values
-    state->rowIndex = 0;
-    state->maxLength = 0;
+    new->prev = builder->last; // append to current list
+    new->next = NULL;          // this is the last element
+    if (builder->last == NULL) // if linked list is empty
+        builder->first = new;
+    else
+        builder->last->next = new; // also do it backwards
+    builder->last = new;
+
+    clearBuilder(builder);
     return 0; // success
 }
 
-// Load level based on filename
-// Returns result containing linked list of levels and statuc code
-// status code: 0 - success, 1 - failed to open file, 2 - failed to allocate memory
-// 3 - invalid file format, 4 - valid, but large levels were removed
-// linked list contains dinamically allocated memory, so must be freed after use
-LoadLevelResult loadLevel(char *filename)
+// Copy title of a level into the name of level being built
+// Long titles are cut before the character that does not fit
+static void copyTitle(LevelBuilder *builder, char *title)
 {
-    LoadLevelResult result; // initialize variables
-    result.result = 0;
-    FILE *file;
-    Level *first = NULL;
-    Level *current;
-    LoadState state;
-
-    state.rowIndex = 0;
-    state.maxLength = 0;
-    emptyLevel(state.level); // clear level
-
-    file = fopen(filename, "r");
-    if (file == NULL) // if failed, return
+    int length = strlen(title);
+    if (length > (int)sizeof(builder->name) - 1)
     {
-        result.result = 1;
-        result.level = NULL;
-        return result;
+        length = sizeof(builder->name) - 1;
+        while (length > 0 && ((unsigned char)title[length] & 0xC0) == 0x80) // do not split UTF-8 characters
+            length--;
     }
+    memcpy(builder->name, title, length);
+    builder->name[length] = '\0';
+}
+
+// Load levels in XSB format, name of level is given in a comment line before it
+// Rows may be run length encoded
+// Result: same as loadLevel
+static LoadLevelResult loadXsb(FILE *file)
+{
+    LoadLevelResult result; // initialize variables
+    result.result = 0;
+    result.level = NULL;
+    LevelBuilder builder;
+    initBuilder(&builder);
+    char line[LINE_SIZE];
 
-    while (fgets(state.line, 64, file) != NULL) // while lines can be read from file
+    while (fgets(line, LINE_SIZE, file) != NULL) // while lines can be read from file
     {
-        state.lineLength = strlen(state.line);
-        while (state.line[state.lineLength - 1] == '\n' || state.line[state.lineLength - 1] == '\r') // remove trailing newline and carriage returns
+        int length = strlen(line);
+        bool cut = length > 0 && line[length - 1] != '\n' && !feof(file);
+        for (int c = cut ? getc(file) : '\n'; c != '\n' && c != EOF; c = getc(file)) // skip rest of long line
+            ;
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) // remove trailing newline and carriage returns
         {
-            state.line[state.lineLength - 1] = '\0';
-            state.lineLength--;
+            line[length - 1] = '\0';
+            length--;
         }
 
-        if (state.line[0] == ';' && state.lineLength >= 3) // if comment <==> level name
+        if (line[0] == ';' && length >= 3) // if comment <==> level name
         {
-            if (state.line[1] == ' ') // if name contains leading space
-                strcpy(state.name, state.line + 2);
+            if (line[1] == ' ') // if name contains leading space
+                copyTitle(&builder, line + 2);
             else
-                strcpy(state.name, state.line + 1);
+                copyTitle(&builder, line + 1);
         }
 
-        if (checkTile(state.line[0])) // if line starts with valid character
+        bool row = checkTile(line[0]) || isRleRow(line); // if line starts with valid character, it is a row
+        bool rle = row && strpbrk(line, "0123456789|") != NULL;
+        if (row && cut) // row longer than the buffer cannot fit
+            builder.tooLarge = true;
+        if (row && !addRleRows(&builder, line))
         {
-            if (state.lineLength > state.maxLength) // track maximum line length
-                state.maxLength = state.lineLength;
-
-            if (state.lineLength <= 19 && state.rowIndex <= 10) // if size is still within limits
-            {
-                for (int i = 0; i < state.lineLength; i++) // copy each tile while checking if valid
-                {
-                    char c = state.line[i];
-                    if (checkTile(c))
-                        state.level[i + 19 * state.rowIndex] = charToTile(c);
-                    else
-                    {
-                        unloadLevel(first); // free memory and return on faliure
-                        result.result = 3;
-                        result.level = NULL;
-                        return result;
-                    }
-                }
-
-                state.rowIndex++; // move to next row
-            }
-            else
-                result.result = 4; // large levels were removed
+            unloadLevel(builder.first); // free memory and return on faliure
+            result.result = 3;
+            return result;
         }
 
-        if (state.lineLength <= 2 && state.level[0] != 0) // end of current level
+        if (length <= 2 && !rle && hasRows(&builder)) // end of current level, short encoded rows like 7# are not
         {
-            if (addLevel(&state, &first, &current) == 2) // add level to linked list
+            int finished = finishLevel(&builder); // add level to linked list
+            if (finished == 2)
             {
                 result.result = 2; // return on memory allocation failure
-                result.level = NULL;
                 return result;
             }
+            if (finished == 4)
+                result.result = 4; // large levels were removed
         }
     }
 
-    if (state.level[0] != 0) // if while loop finished and has not added last level, when file ends without empty line at the end
+    if (hasRows(&builder)) // if while loop finished and has not added last level, when file ends without empty line at the end
     {
-        if (addLevel(&state, &first, &current) == 2)
+        int finished = finishLevel(&builder);
+        if (finished == 2)
         {
             result.result = 2;
-            result.level = NULL;
             return result;
         }
+        if (finished == 4)
+            result.result = 4;
     }
 
-    fclose(file); // close file
+    result.level = builder.first; // set resulting linked list
+    return result;
+}
+
+// Check if filename ends with extension, letter case is ignored
+static bool hasExtension(char *filename, char *extension)
+{
+    size_t length = strlen(filename), extensionLength = strlen(extension);
+    if (length < extensionLength)
+        return false;
+    for (size_t i = 0; i < extensionLength; i++)
+    {
+        if (tolower((unsigned char)filename[length - extensionLength + i]) != extension[i])
+            return false;
+    }
+    return true;
+}
 
-    result.level = first; // set resulting linked list
+// Check if file is XML, its first character after whitespace and byte order mark is <
+// File is rewound
+static bool isXml(FILE *file)
+{
+    int c;
+    do
+        c = getc(file);
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == 0xEF || c == 0xBB || c == 0xBF);
+    rewind(file);
+    return c == '<';
+}
+
+// Load level based on filename
+// XSB files, SLC collections (XML) and .sok files are recognized, also when gzip compressed with .gz extension
+// Returns result containing linked list of levels and statuc code
+// status code: 0 - success, 1 - failed to open file, 2 - failed to allocate memory
+// 3 - invalid file format, 4 - valid, but large levels were removed
+// linked list contains dinamically allocated memory, so must be freed after use
+LoadLevelResult loadLevel(char *filename)
+{
+    LoadLevelResult result;
+    bool compressed = hasExtension(filename, ".gz");
+    FILE *file = compressed ? openGzip(filename) : fopen(filename, "r");
+    if (file == NULL) // if failed, return
+    {
+        result.result = 1;
+        result.level = NULL;
+        return result;
+    }
 
+    if (isXml(file))
+        result = loadSlc(file);
+    else if (hasExtension(filename, compressed ? ".sok.gz" : ".sok"))
+        result = loadSok(file);
+    else
+        result = loadXsb(file);
+
+    fclose(file); // close file
     return result;
 }
 
 // Frees specified level, does not free entire linked list!
-static void freeLevel(Level *level)
+void freeLevel(Level *level)
 {
     if (level != NULL)
     {
@@ -285,31 +404,111 @@ void unloadLevel(Level *level)
     freeLevel(level);
 }
 
-// Save linked list of levels to specified file
-// Returns true on success, false on failure
-bool saveLevel(Level *level, char *filename)
+// Size of level in saved file format, including name line and separating empty line
+static size_t savedSize(Level *level)
 {
-    FILE *file;
+    return strlen(level->name) + 3 + (size_t)(level->size.x + 1) * level->size.y + 1;
+}
 
-    file = fopen(filename, "w");
-    if (file == NULL) // return if file was not opened successfully
-        return false;
+// Write row of level run length encoded, like 4#2-$.#, floor is written as -
+// Rows without walls are written plain, the loader recognizes encoded rows by their walls
+// Returns pointer to end of written data
+static char *writeRleRow(TileState *row, int width, char *buffer)
+{
+    bool wall = false;
+    for (int i = 0; i < width; i++)
+        wall = wall || row[i] == wallS;
+    if (!wall)
+    {
+        for (int i = 0; i < width; i++)
+            *buffer++ = tileToChar(row[i]);
+        return buffer;
+    }
+
+    for (int i = 0; i < width;)
+    {
+        int count = 1;
+        while (i + count < width && row[i + count] == row[i])
+            count++;
+        char tile = tileToChar(row[i]);
+        if (count > 1)
+            buffer += sprintf(buffer, "%d", count);
+        *buffer++ = tile == ' ' ? '-' : tile;
+        i += count;
+    }
+    return buffer;
+}
 
-    while (level != NULL) // while there are levels to save
+// Write level in file format to buffer
+// Rle: rows are run length encoded, never longer than plain rows
+// Returns pointer to end of written data
+static char *writeLevel(Level *level, char *buffer, bool rle)
+{
+    buffer += sprintf(buffer, "; %s\n", level->name); // write name of level
+    for (int i = 0; i < level->size.y; i++)            // write rows of level
     {
-        fprintf(file, "; %s\n", level->name);   // write name of level
-        for (int i = 0; i < level->size.y; i++) // write rows of level
+        if (rle)
+            buffer = writeRleRow(level->tiles + i * level->size.x, level->size.x, buffer);
+        else
         {
             for (int j = 0; j < level->size.x; j++) // write columns of level
             {
-                fputc(tileToChar(level->tiles[j + i * level->size.x]), file); // convert ot character and write
+                *buffer++ = tileToChar(level->tiles[j + i * level->size.x]); // convert ot character and write
             }
-            fputc('\n', file); // newline at end of every line
         }
-        fputc('\n', file); // newline to separate levels
+        *buffer++ = '\n'; // newline at end of every line
+    }
+    *buffer++ = '\n'; // newline to separate levels
+    return buffer;
+}
+
+// Write whole file at once and make sure it reaches the disk
+// Returns true on success, false on failure
+static bool writePlain(char *filename, char *data, size_t size)
+{
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        return false;
+    bool success = fwrite(data, 1, size, file) == size;
+    success = fflush(file) == 0 && success;
+    success = fsync(fileno(file)) == 0 && success;
+    success = fclose(file) == 0 && success;
+    return success;
+}
+
+// Save linked list of levels to specified file
+// Levels are written to a temporary file first, which replaces the original file only after it was written completely
+// Files with .gz extension are written gzip compressed
+// Rle: write rows run length encoded, which makes large sparse levels smaller
+// Returns true on success, false on failure
+bool saveLevel(Level *level, char *filename, bool rle)
+{
+    size_t size = 0;
+    for (Level *current = level; current != NULL; current = current->next) // calculate size of file
+        size += savedSize(current);
+
+    char *buffer = (char *)malloc(size + 1); // sprintf writes terminating zero after last name
+    if (buffer == NULL)
+        return false;
+    char *end = buffer;
+    for (Level *current = level; current != NULL; current = current->next) // convert every level to text
+        end = writeLevel(current, end, rle);
 
-        level = level->next; // go to next level
+    char *tempname = (char *)malloc(strlen(filename) + 5);
+    if (tempname == NULL)
+    {
+        free(buffer);
+        return false;
     }
+    strcpy(tempname, filename);
+    strcat(tempname, ".tmp");
 
-    return fclose(file) == 0; // return file close success
-}
\ No newline at end of file
+    bool written = hasExtension(filename, ".gz") ? writeGzip(tempname, buffer, end - buffer) : writePlain(tempname, buffer, end - buffer);
+    bool success = written && rename(tempname, filename) == 0; // replace original file
+    if (!success)
+        remove(tempname);
+
+    free(tempname);
+    free(buffer);
+    return success;
+}
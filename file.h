@@ -4,6 +4,10 @@
 #include <stdbool.h>
 #include "coordinates.h"
 
+#ifdef DEBUGMALLOC
+#define DEBUGMALLOC_BLOCK_SIZE ((size_t)256 << 20) // block limit set at startup of debugmalloc builds, the solver stays below it
+#endif
+
 typedef enum TileState
 {
     invalidS = 0,
@@ -31,9 +35,28 @@ typedef struct LoadLevelResult
     Level *level;
 } LoadLevelResult;
 
+// Collects rows of levels while a file is read, used by the loaders of each format
+typedef struct LevelBuilder
+{
+    char name[64];
+    TileState tiles[209]; // 19 x 11 squares, rows are 19 tiles apart
+    int rows;
+    int width;     // length of longest row
+    bool tooLarge; // a row did not fit, level is dropped when finished
+    Level *first;  // finished levels
+    Level *last;
+} LevelBuilder;
+
+void initBuilder(LevelBuilder *builder);
+bool hasRows(LevelBuilder *builder);
+bool addRow(LevelBuilder *builder, char *row, int length);
+bool addRleRows(LevelBuilder *builder, char *line);
+int finishLevel(LevelBuilder *builder);
+
 LoadLevelResult loadLevel(char *filename);
 void unloadLevel(Level *level);
+void freeLevel(Level *level);
 
-bool saveLevel(Level *level, char *filename);
+bool saveLevel(Level *level, char *filename, bool rle);
 
 #endif
\ No newline at end of file
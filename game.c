@@ -0,0 +1,155 @@
+#include "game.h"
+#include "file.h"
+#include "move.h"
+#include "replay.h"
+#include "coordinates.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Initialize game without level
+void initGame(Game *game)
+{
+    game->start = NULL;
+    game->level = NULL;
+    game->player.x = -1;
+    game->player.y = -1;
+    initMoves(&game->moves);
+    game->pushes = 0;
+}
+
+// Start playing level from its starting position
+// Level is copied, the original is never modified but must outlive the game
+// Returns false on memory allocation failure, game has no level then
+bool startGame(Game *game, Level *level)
+{
+    if (game->level != NULL) // free previous level
+    {
+        free(game->level->tiles);
+        free(game->level);
+        game->level = NULL;
+    }
+    clearMoves(&game->moves);
+    game->pushes = 0;
+    game->start = level;
+
+    Level *copy = (Level *)malloc(sizeof(Level));
+    if (copy == NULL)
+        return false;
+    memcpy(copy, level, sizeof(Level)); // name and neighbours are shared
+    copy->tiles = (TileState *)malloc(sizeof(TileState) * level->size.x * level->size.y);
+    if (copy->tiles == NULL)
+    {
+        free(copy);
+        return false;
+    }
+    memcpy(copy->tiles, level->tiles, sizeof(TileState) * level->size.x * level->size.y);
+    game->level = copy;
+    takePlayer(game->level, &game->player); // extract player position and change tile under player
+    return true;
+}
+
+// Start current level again from its starting position
+// Returns false if there is no level or memory allocation failed
+bool restartGame(Game *game)
+{
+    if (game->start == NULL)
+        return false;
+    return startGame(game, game->start);
+}
+
+// Move player and record move
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+// Move history is dropped on memory allocation failure, so undo stops working
+// Returns result of movePlayer
+MoveResult gameMove(Game *game, int dir)
+{
+    MoveResult result = movePlayer(game->level, &game->player, dir);
+    if (result == blockedM)
+        return result;
+    if (result == pushedM)
+        game->pushes++;
+    if (!appendMove(&game->moves, dir, result == pushedM))
+        freeMoves(&game->moves);
+    return result;
+}
+
+// Take back last recorded move
+// Returns false if there is nothing to undo
+bool undoMove(Game *game)
+{
+    if (game->moves.length == 0)
+        return false;
+    bool push;
+    int dir = charToMove(game->moves.moves[game->moves.length - 1], &push);
+    revertMove(game->level, &game->player, dir, push);
+    if (push)
+        game->pushes--;
+    game->moves.length--;
+    game->moves.moves[game->moves.length] = '\0';
+    return true;
+}
+
+// Apply LURD moves to game and record them
+// Whitespace is skipped, moves stop at the first one that cannot be made
+// Result: same as replayMoves
+ReplayResult playMoves(Game *game, char *lurd)
+{
+    ReplayResult result = {0, 0, 0, false};
+
+    for (char *c = lurd; *c != '\0'; c++)
+    {
+        if (*c == ' ' || *c == '\n' || *c == '\r' || *c == '\t')
+            continue;
+        bool push;
+        int dir = charToMove(*c, &push);
+        if (dir == -1)
+        {
+            result.result = 1;
+            break;
+        }
+        MoveResult move = gameMove(game, dir);
+        if (move == blockedM)
+        {
+            result.result = 2;
+            break;
+        }
+        if ((move == pushedM) != push)
+        {
+            undoMove(game); // move was made, but differs from the recorded one
+            result.result = 3;
+            break;
+        }
+        result.moves++;
+        if (push)
+            result.pushes++;
+    }
+
+    result.finished = gameFinished(game);
+    return result;
+}
+
+// Returns true if all targets of current position are covered by crates
+bool gameFinished(Game *game)
+{
+    return game->level != NULL && levelFinished(game->level);
+}
+
+// Free level copy and moves of game
+// Original level is not freed
+void freeGame(Game *game)
+{
+    if (game->level != NULL)
+    {
+        free(game->level->tiles);
+        free(game->level);
+    }
+    freeMoves(&game->moves);
+    game->level = NULL;
+    game->start = NULL;
+}
@@ -0,0 +1,28 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include "file.h"
+#include "coordinates.h"
+#include "move.h"
+#include "replay.h"
+
+typedef struct Game
+{
+    Level *start; // level as loaded, never modified
+    Level *level; // current state, shares name, prev and next with start, player is not on the tiles
+    Coordinates player;
+    MoveList moves; // moves since start, LURD
+    int pushes;
+} Game;
+
+void initGame(Game *game);
+bool startGame(Game *game, Level *level);
+bool restartGame(Game *game);
+MoveResult gameMove(Game *game, int dir);
+bool undoMove(Game *game);
+ReplayResult playMoves(Game *game, char *lurd);
+bool gameFinished(Game *game);
+void freeGame(Game *game);
+
+#endif
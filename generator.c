@@ -0,0 +1,322 @@
+#include "generator.h"
+#include "file.h"
+#include "solver.h"
+#include "coordinates.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Coordinate offsets for each direction
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+// Candidate level during generation
+typedef struct Candidate
+{
+    int w;
+    int h;
+    TileState *tiles; // walls, floors and targets only
+    bool *crates;
+    int player;
+    int *queue;    // work area of searches
+    bool *reached; // work area of searches
+} Candidate;
+
+// Get next pseudo random number, seed is updated
+// Every thread must use its own seed
+unsigned int randomNumber(unsigned long long *seed)
+{
+    *seed ^= *seed >> 12; // xorshift64*
+    *seed ^= *seed << 25;
+    *seed ^= *seed >> 27;
+    return (unsigned int)((*seed * 2685821657736338717ULL) >> 32);
+}
+
+// Returns true if neither walls nor crates are on tile
+static bool isFree(Candidate *candidate, int tile)
+{
+    return candidate->tiles[tile] != wallS && !candidate->crates[tile];
+}
+
+// Get neighbour of tile in direction, or -1 if it is outside of level
+static int neighbour(Candidate *candidate, int tile, int dir)
+{
+    int x = tile % candidate->w + dirX[dir];
+    int y = tile / candidate->w + dirY[dir];
+    if (x < 0 || y < 0 || x >= candidate->w || y >= candidate->h)
+        return -1;
+    return x + y * candidate->w;
+}
+
+// Mark tiles reachable from start through free tiles in candidate->reached
+// Returns number of reached tiles
+static int markReachable(Candidate *candidate, int start)
+{
+    memset(candidate->reached, 0, sizeof(bool) * candidate->w * candidate->h);
+    int head = 0, tail = 0;
+    candidate->reached[start] = true;
+    candidate->queue[tail++] = start;
+    while (head < tail)
+    {
+        int tile = candidate->queue[head++];
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int next = neighbour(candidate, tile, dir);
+            if (next != -1 && !candidate->reached[next] && isFree(candidate, next))
+            {
+                candidate->reached[next] = true;
+                candidate->queue[tail++] = next;
+            }
+        }
+    }
+    return tail;
+}
+
+// Pick random tile from the tiles marked in candidate->reached
+// Count: number of marked tiles
+static int randomReached(Candidate *candidate, int count, unsigned long long *seed)
+{
+    int pick = (int)(randomNumber(seed) % (unsigned int)count);
+    for (int i = 0; i < candidate->w * candidate->h; i++)
+    {
+        if (candidate->reached[i] && pick-- == 0)
+            return i;
+    }
+    return -1;
+}
+
+// Fill inner tiles randomly with walls and floors, then wall off everything but the largest floor area
+// Returns size of the floor area
+static int buildLayout(Candidate *candidate, int wallPercent, unsigned long long *seed)
+{
+    int w = candidate->w, h = candidate->h;
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            bool border = x == 0 || y == 0 || x == w - 1 || y == h - 1;
+            candidate->tiles[x + y * w] = border || (int)(randomNumber(seed) % 100) < wallPercent ? wallS : floorTileS;
+        }
+    }
+
+    int best = -1, bestSize = 0;
+    bool *seen = (bool *)calloc(w * h, sizeof(bool)); // tiles of areas already measured
+    if (seen == NULL)
+        return -1;
+    for (int i = 0; i < w * h; i++)
+    {
+        if (candidate->tiles[i] == wallS || seen[i])
+            continue;
+        int size = markReachable(candidate, i);
+        for (int j = 0; j < w * h; j++)
+            seen[j] = seen[j] || candidate->reached[j];
+        if (size > bestSize)
+        {
+            best = i;
+            bestSize = size;
+        }
+    }
+    free(seen);
+    if (best == -1)
+        return 0;
+
+    markReachable(candidate, best);
+    for (int i = 0; i < w * h; i++)
+    {
+        if (!candidate->reached[i])
+            candidate->tiles[i] = wallS;
+    }
+    return bestSize;
+}
+
+// Place targets with crates on them and the player on random floor tiles
+// Returns false if there is not enough room
+static bool placeObjects(Candidate *candidate, int crates, unsigned long long *seed)
+{
+    for (int i = 0; i < crates; i++)
+    {
+        int count = 0;
+        for (int j = 0; j < candidate->w * candidate->h; j++) // every free floor tile can get a target
+        {
+            candidate->reached[j] = candidate->tiles[j] == floorTileS && !candidate->crates[j];
+            count += candidate->reached[j];
+        }
+        if (count == 0)
+            return false;
+        int tile = randomReached(candidate, count, seed);
+        candidate->tiles[tile] = targetS;
+        candidate->crates[tile] = true;
+    }
+
+    int count = 0;
+    for (int j = 0; j < candidate->w * candidate->h; j++)
+    {
+        candidate->reached[j] = isFree(candidate, j);
+        count += candidate->reached[j];
+    }
+    if (count == 0)
+        return false;
+    candidate->player = randomReached(candidate, count, seed);
+    return true;
+}
+
+// Pull random crates away from targets, reversing pushes
+// Every position reached this way can be solved by pushing the crates back
+// Returns number of crates not on targets after pulling
+static int pullCrates(Candidate *candidate, int pulls, unsigned long long *seed)
+{
+    int size = candidate->w * candidate->h;
+    for (int i = 0; i < pulls; i++)
+    {
+        markReachable(candidate, candidate->player);
+        int options = 0;
+        for (int crate = 0; crate < size; crate++) // count pulls: player beside crate with free tile behind
+        {
+            if (!candidate->crates[crate])
+                continue;
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int stand = neighbour(candidate, crate, dir);
+                int back = stand == -1 ? -1 : neighbour(candidate, stand, dir);
+                if (back != -1 && candidate->reached[stand] && isFree(candidate, back))
+                    options++;
+            }
+        }
+        if (options == 0)
+            break;
+        int pick = (int)(randomNumber(seed) % (unsigned int)options);
+        for (int crate = 0; crate < size && pick >= 0; crate++)
+        {
+            if (!candidate->crates[crate])
+                continue;
+            for (int dir = 0; dir < 4 && pick >= 0; dir++)
+            {
+                int stand = neighbour(candidate, crate, dir);
+                int back = stand == -1 ? -1 : neighbour(candidate, stand, dir);
+                if (back == -1 || !candidate->reached[stand] || !isFree(candidate, back) || pick-- != 0)
+                    continue;
+                candidate->crates[crate] = false; // crate follows player by one tile
+                candidate->crates[stand] = true;
+                candidate->player = back;
+            }
+        }
+    }
+
+    int away = 0;
+    for (int i = 0; i < size; i++)
+        away += candidate->crates[i] && candidate->tiles[i] != targetS;
+    return away;
+}
+
+// Convert candidate to level
+// Returns NULL on memory allocation failure
+static Level *toLevel(Candidate *candidate)
+{
+    Level *level = (Level *)malloc(sizeof(Level));
+    if (level == NULL)
+        return NULL;
+    level->tiles = (TileState *)malloc(sizeof(TileState) * candidate->w * candidate->h);
+    if (level->tiles == NULL)
+    {
+        free(level);
+        return NULL;
+    }
+    level->size.x = candidate->w;
+    level->size.y = candidate->h;
+    level->name = NULL;
+    level->prev = NULL;
+    level->next = NULL;
+    for (int i = 0; i < candidate->w * candidate->h; i++)
+    {
+        TileState tile = candidate->tiles[i];
+        if (candidate->crates[i])
+            tile = tile == targetS ? crateOnTargetS : crateS;
+        else if (i == candidate->player)
+            tile = tile == targetS ? playerOnTargetS : playerS;
+        level->tiles[i] = tile;
+    }
+    return level;
+}
+
+// Number of bits needed to write value
+static int bitLength(long value)
+{
+    int bits = 0;
+    while (value > 0)
+    {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+// Build random layout, place objects and pull crates away from targets
+// Returns 0 on success, 1 if candidate is rejected, 2 on memory allocation failure
+static int buildCandidate(Candidate *candidate, GeneratorParams *params, unsigned long long *seed)
+{
+    int area = buildLayout(candidate, params->wallPercent, seed);
+    if (area < 0)
+        return 2;
+    if (area < params->crates * 2 + 2 || !placeObjects(candidate, params->crates, seed)) // too cramped
+        return 1;
+    if (pullCrates(candidate, params->pulls, seed) < (params->crates + 1) / 2) // mostly solved already
+        return 1;
+    return 0;
+}
+
+// Generate one candidate level and verify it with the solver
+// Thread safe as long as every thread uses its own seed
+// Result: 0 - level generated, 1 - candidate rejected, 2 - memory allocation failure
+// Level of result must be freed with freeLevel
+GeneratedLevel generateLevel(GeneratorParams *params, unsigned long long *seed)
+{
+    GeneratedLevel result = {2, NULL, 0, 0, 0, 0};
+    Candidate candidate;
+    candidate.w = params->size.x;
+    candidate.h = params->size.y;
+    int size = candidate.w * candidate.h;
+    candidate.tiles = (TileState *)malloc(sizeof(TileState) * size);
+    candidate.crates = (bool *)calloc(size, sizeof(bool));
+    candidate.queue = (int *)malloc(sizeof(int) * size);
+    candidate.reached = (bool *)malloc(sizeof(bool) * size);
+    Level *level = NULL;
+    if (candidate.tiles != NULL && candidate.crates != NULL && candidate.queue != NULL && candidate.reached != NULL)
+    {
+        result.result = buildCandidate(&candidate, params, seed);
+        if (result.result == 0)
+        {
+            level = toLevel(&candidate);
+            result.result = level == NULL ? 2 : 1;
+        }
+    }
+    free(candidate.tiles);
+    free(candidate.crates);
+    free(candidate.queue);
+    free(candidate.reached);
+    if (level == NULL)
+        return result;
+
+    SolverResult solved = solveLevel(level, params->limits);
+    if (solved.result == 0 && solved.pushes >= params->minPushes)
+    {
+        result.result = 0;
+        result.level = level;
+        result.moves = solved.moves;
+        result.pushes = solved.pushes;
+        result.nodes = solved.nodes;
+        result.score = solved.pushes + 4 * bitLength(solved.nodes);
+    }
+    else
+    {
+        result.result = solved.result == 5 ? 2 : 1;
+        freeLevel(level);
+    }
+    freeSolverResult(&solved);
+    return result;
+}
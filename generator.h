@@ -0,0 +1,32 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdbool.h>
+#include "file.h"
+#include "coordinates.h"
+#include "solver.h"
+
+typedef struct GeneratorParams
+{
+    Coordinates size;    // size of level including outer walls, at most 19 x 11 to fit the screen
+    int crates;          // number of crates and targets
+    int wallPercent;     // chance of inner tiles becoming walls
+    int pulls;           // number of reverse pulls from the solved position
+    int minPushes;       // candidates with shorter solutions are rejected
+    SolverLimits limits; // limits of verifying a candidate
+} GeneratorParams;
+
+typedef struct GeneratedLevel
+{
+    int result;
+    Level *level; // NULL unless result is 0, name is NULL
+    int moves;    // moves of solution found by solver
+    int pushes;   // pushes of solution found by solver, the least possible unless limits.macros is set
+    long nodes;   // positions stored by solver
+    int score;    // difficulty, grows with pushes and search effort
+} GeneratedLevel;
+
+unsigned int randomNumber(unsigned long long *seed);
+GeneratedLevel generateLevel(GeneratorParams *params, unsigned long long *seed);
+
+#endif
@@ -0,0 +1,106 @@
+#define _GNU_SOURCE // fopencookie
+#include "gzip.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef SOKOBAN_ZLIB
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#endif
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+#ifdef SOKOBAN_ZLIB
+
+// Read decompressed data for the FILE wrapper
+static ssize_t readCookie(void *cookie, char *buffer, size_t size)
+{
+    int read = gzread((gzFile)cookie, buffer, size > 1 << 30 ? 1 << 30 : (unsigned)size);
+    return read < 0 ? -1 : read;
+}
+
+// Seek in decompressed data, needed by rewind
+// Seeking backwards starts decompression again from the beginning of file
+static int seekCookie(void *cookie, off64_t *position, int whence)
+{
+    if (whence == SEEK_END)
+        return -1;
+    z_off_t result = gzseek((gzFile)cookie, *position, whence);
+    if (result < 0)
+        return -1;
+    *position = result;
+    return 0;
+}
+
+// Close compressed file with the FILE wrapper
+static int closeCookie(void *cookie)
+{
+    return gzclose((gzFile)cookie) == Z_OK ? 0 : -1;
+}
+
+// Open gzip compressed file for reading, data is decompressed while it is read
+// The returned file works with stdio functions and is closed with fclose
+// Returns NULL if file cannot be opened
+FILE *openGzip(char *filename)
+{
+    gzFile compressed = gzopen(filename, "rb");
+    if (compressed == NULL)
+        return NULL;
+    gzbuffer(compressed, 64 * 1024); // fewer reads of large collections
+    cookie_io_functions_t functions = {readCookie, NULL, seekCookie, closeCookie};
+    FILE *file = fopencookie(compressed, "r", functions);
+    if (file == NULL)
+        gzclose(compressed);
+    return file;
+}
+
+// Write data gzip compressed to file and make sure it reaches the disk
+// Returns true on success, false on failure
+bool writeGzip(char *filename, char *data, size_t size)
+{
+    int descriptor = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (descriptor == -1)
+        return false;
+    gzFile compressed = gzdopen(descriptor, "wb");
+    if (compressed == NULL)
+    {
+        close(descriptor);
+        return false;
+    }
+
+    bool success = true;
+    while (size > 0 && success) // gzwrite takes at most UINT_MAX bytes at once
+    {
+        unsigned chunk = size > 1 << 30 ? 1 << 30 : (unsigned)size;
+        success = gzwrite(compressed, data, chunk) == (int)chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    success = gzflush(compressed, Z_FINISH) == Z_OK && success;
+    success = fsync(descriptor) == 0 && success;
+    success = gzclose(compressed) == Z_OK && success; // closes descriptor too
+    return success;
+}
+
+#else // built without zlib, compressed files are not supported
+
+FILE *openGzip(char *filename)
+{
+    (void)filename;
+    return NULL;
+}
+
+bool writeGzip(char *filename, char *data, size_t size)
+{
+    (void)filename;
+    (void)data;
+    (void)size;
+    return false;
+}
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef GZIP_H
+#define GZIP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+FILE *openGzip(char *filename);
+bool writeGzip(char *filename, char *data, size_t size);
+
+#endif
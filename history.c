@@ -0,0 +1,246 @@
+#include "history.h"
+#include "file.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Changes are stored in a ring buffer, oldest changes are dropped when buffer is full or memory budget is exceeded
+// Deleted levels and replaced names are owned by history until their change is dropped
+
+// Initialize empty history for at most capacity changes
+// Budget is the memory limit of stored changes in bytes, including deleted levels and names
+// Returns false on memory allocation failure
+bool initHistory(History *history, int capacity, size_t budget)
+{
+    history->changes = (Change *)malloc(sizeof(Change) * capacity);
+    history->capacity = history->changes == NULL ? 0 : capacity;
+    history->start = 0;
+    history->count = 0;
+    history->position = 0;
+    history->memory = 0;
+    history->budget = budget;
+    history->group = 0;
+    history->grouping = false;
+    return history->changes != NULL;
+}
+
+// Get change by index, 0 is the oldest change
+static Change *getChange(History *history, int index)
+{
+    return history->changes + (history->start + index) % history->capacity;
+}
+
+// Memory used by level, including tiles and name
+static size_t levelMemory(Level *level)
+{
+    return sizeof(Level) + sizeof(TileState) * level->size.x * level->size.y + strlen(level->name) + 1;
+}
+
+// Free memory owned by change
+// Done: true if change is currently applied
+static void dropChange(Change *change, bool done)
+{
+    if (change->type == deleteC && done) // deleted level is not in the list
+        freeLevel(change->level);
+    if (change->type == insertC && !done) // inserted level was removed from the list
+        freeLevel(change->level);
+    if (change->type == renameC)
+        free(change->name);
+}
+
+// Drop oldest change to free memory
+static void dropOldest(History *history)
+{
+    history->memory -= getChange(history, 0)->memory;
+    dropChange(getChange(history, 0), history->position > 0);
+    history->start = (history->start + 1) % history->capacity;
+    history->count--;
+    if (history->position > 0)
+        history->position--;
+}
+
+// Store change as newest done change
+// Changes that could be redone are dropped, as they are not valid anymore
+// If history could not be initialized, resources of change are freed immediately
+static void addChange(History *history, Change change)
+{
+    if (history->capacity == 0)
+    {
+        dropChange(&change, true);
+        return;
+    }
+
+    while (history->count > history->position) // drop redo changes
+    {
+        history->count--;
+        history->memory -= getChange(history, history->count)->memory;
+        dropChange(getChange(history, history->count), false);
+    }
+    if (history->count == history->capacity)
+        dropOldest(history);
+
+    if (!history->grouping) // every change is its own group outside of groups
+        history->group++;
+    change.group = history->group;
+    *getChange(history, history->count) = change;
+    history->count++;
+    history->position++;
+    history->memory += change.memory;
+
+    while (history->memory > history->budget && history->count > 1) // keep newest change even if it is over budget
+        dropOldest(history);
+}
+
+// Free every change and memory of history
+// Levels still in the linked list are not freed
+void freeHistory(History *history)
+{
+    for (int i = 0; i < history->count; i++)
+        dropChange(getChange(history, i), i < history->position);
+    free(history->changes);
+    history->changes = NULL;
+    history->capacity = 0;
+    history->count = 0;
+    history->position = 0;
+    history->memory = 0;
+}
+
+// Start collecting changes into one group, so they can be undone in one step
+// Oldest groups might be dropped partially if history runs out of space
+void beginGroup(History *history)
+{
+    history->group++;
+    history->grouping = true;
+}
+
+// Finish group started by beginGroup
+void endGroup(History *history)
+{
+    history->grouping = false;
+}
+
+// Put level back to the linked list between its stored prev and next levels
+// Neighbours must be the same as when the level was unlinked
+void linkLevel(Level **first, Level *level)
+{
+    if (level->prev != NULL)
+        level->prev->next = level;
+    else
+        *first = level;
+    if (level->next != NULL)
+        level->next->prev = level;
+}
+
+// Remove level from the linked list
+// Prev and next pointers of level are kept, so it can be linked back later
+void unlinkLevel(Level **first, Level *level)
+{
+    if (level->prev != NULL)
+        level->prev->next = level->next;
+    else
+        *first = level->next;
+    if (level->next != NULL)
+        level->next->prev = level->prev;
+}
+
+// Record change of a single tile
+void recordTile(History *history, Level *level, int index, TileState before, TileState after)
+{
+    Change change = {tileC, level, index, before, after, NULL, sizeof(Change), 0};
+    addChange(history, change);
+}
+
+// Record level inserted to the linked list
+void recordInsert(History *history, Level *level)
+{
+    Change change = {insertC, level, 0, invalidS, invalidS, NULL, sizeof(Change) + levelMemory(level), 0};
+    addChange(history, change);
+}
+
+// Record level removed from the linked list with unlinkLevel
+// History takes ownership of level
+void recordDelete(History *history, Level *level)
+{
+    Change change = {deleteC, level, 0, invalidS, invalidS, NULL, sizeof(Change) + levelMemory(level), 0};
+    addChange(history, change);
+}
+
+// Record rename of level, level must already have its new name
+// History takes ownership of old name
+void recordRename(History *history, Level *level, char *oldName)
+{
+    Change change = {renameC, level, 0, invalidS, invalidS, oldName, sizeof(Change) + strlen(oldName) + 1, 0};
+    addChange(history, change);
+}
+
+// Apply or revert change
+// Undo: true to revert change, false to apply it again
+static void applyChange(Change *change, Level **first, bool undo)
+{
+    char *name;
+    switch (change->type)
+    {
+    case tileC:
+        change->level->tiles[change->index] = undo ? change->before : change->after;
+        break;
+    case insertC:
+        if (undo)
+            unlinkLevel(first, change->level);
+        else
+            linkLevel(first, change->level);
+        break;
+    case deleteC:
+        if (undo)
+            linkLevel(first, change->level);
+        else
+            unlinkLevel(first, change->level);
+        break;
+    case renameC: // swap current and stored name
+        name = change->level->name;
+        change->level->name = change->name;
+        change->name = name;
+        break;
+    default:
+        break;
+    }
+}
+
+// Revert newest done group of changes
+// Returns last reverted change, NULL if there is nothing to undo
+Change *undoChange(History *history, Level **first)
+{
+    if (history->position == 0)
+        return NULL;
+    Change *change;
+    int group = getChange(history, history->position - 1)->group;
+    do
+    {
+        history->position--;
+        change = getChange(history, history->position);
+        applyChange(change, first, true);
+    } while (history->position > 0 && getChange(history, history->position - 1)->group == group);
+    return change;
+}
+
+// Apply oldest undone group of changes again
+// Returns last applied change, NULL if there is nothing to redo
+Change *redoChange(History *history, Level **first)
+{
+    if (history->position == history->count)
+        return NULL;
+    Change *change;
+    int group = getChange(history, history->position)->group;
+    do
+    {
+        change = getChange(history, history->position);
+        history->position++;
+        applyChange(change, first, false);
+    } while (history->position < history->count && getChange(history, history->position)->group == group);
+    return change;
+}
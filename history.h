@@ -0,0 +1,58 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "file.h"
+
+typedef enum ChangeType
+{
+    tileC,
+    insertC,
+    deleteC,
+    renameC
+} ChangeType;
+
+typedef struct Change
+{
+    ChangeType type;
+    Level *level;
+    int index;        // index of changed tile
+    TileState before; // tile before and after change
+    TileState after;
+    char *name; // name of level that is currently not in use
+    size_t memory;
+    int group; // changes of the same group are undone and redone together
+} Change;
+
+typedef struct History
+{
+    Change *changes; // ring buffer of changes
+    int capacity;
+    int start;    // index of oldest change
+    int count;    // number of stored changes
+    int position; // number of done changes, changes after this can be redone
+    size_t memory;
+    size_t budget;
+    int group;     // group of newest change
+    bool grouping; // true while changes are collected to one group
+} History;
+
+bool initHistory(History *history, int capacity, size_t budget);
+void freeHistory(History *history);
+
+void beginGroup(History *history);
+void endGroup(History *history);
+
+void linkLevel(Level **first, Level *level);
+void unlinkLevel(Level **first, Level *level);
+
+void recordTile(History *history, Level *level, int index, TileState before, TileState after);
+void recordInsert(History *history, Level *level);
+void recordDelete(History *history, Level *level);
+void recordRename(History *history, Level *level, char *oldName);
+
+Change *undoChange(History *history, Level **first);
+Change *redoChange(History *history, Level **first);
+
+#endif
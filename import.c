@@ -0,0 +1,429 @@
+#include "import.h"
+#include "file.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Both importers read the file as a stream with fixed size buffers and pass rows to a LevelBuilder,
+// so memory use does not depend on the size of the archive, only on the levels kept
+
+#define ROW_SIZE 64   // longer rows are too large for the game anyway
+#define TAG_SIZE 512  // longer XML tags are cut, only their start is needed
+#define LINE_SIZE 256 // longer .sok lines are cut
+
+// Convert tile character of other formats to XSB
+// - and _ are floor, p and b are player and box in some .sok files
+static char normalizeTile(char c)
+{
+    switch (c)
+    {
+    case '-':
+    case '_':
+        return ' ';
+    case 'p':
+        return '@';
+    case 'P':
+        return '+';
+    case 'b':
+        return '$';
+    case 'B':
+        return '*';
+    default:
+        return c;
+    }
+}
+
+// Get length of valid UTF-8 sequence starting at text
+// Returns 0 if bytes are not valid UTF-8
+static int utf8Length(unsigned char *text)
+{
+    int length = text[0] < 0x80 ? 1 : text[0] >= 0xC2 && text[0] <= 0xDF ? 2 : text[0] >= 0xE0 && text[0] <= 0xEF ? 3 : text[0] >= 0xF0 && text[0] <= 0xF4 ? 4 : 0;
+    for (int i = 1; i < length; i++)
+    {
+        if ((text[i] & 0xC0) != 0x80)
+            return 0;
+    }
+    return length;
+}
+
+// Write code point as UTF-8
+// Returns number of bytes written, at most 4
+static int encodeUtf8(unsigned long code, char *out)
+{
+    if (code < 0x80)
+    {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800)
+    {
+        out[0] = (char)(0xC0 | code >> 6);
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000)
+    {
+        out[0] = (char)(0xE0 | code >> 12);
+        out[1] = (char)(0x80 | (code >> 6 & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | code >> 18);
+    out[1] = (char)(0x80 | (code >> 12 & 0x3F));
+    out[2] = (char)(0x80 | (code >> 6 & 0x3F));
+    out[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+}
+
+// Copy level name, which is cut to fit 63 bytes without splitting characters
+// Text that is not valid UTF-8 is read as Latin-1, the usual encoding of older archives
+static void copyName(char *name, char *text)
+{
+    bool utf8 = true;
+    for (unsigned char *c = (unsigned char *)text; *c != '\0' && utf8; c += utf8Length(c) == 0 ? 1 : utf8Length(c))
+        utf8 = utf8Length(c) != 0;
+
+    int length = 0;
+    for (unsigned char *c = (unsigned char *)text; *c != '\0';)
+    {
+        char character[4];
+        int size = utf8 ? utf8Length(c) : encodeUtf8(*c, character);
+        if (length + size > 63)
+            break;
+        memcpy(name + length, utf8 ? (char *)c : character, size);
+        length += size;
+        c += utf8 ? size : 1;
+    }
+    name[length] = '\0';
+}
+
+// Remove spaces from both ends of text in place
+// Returns start of trimmed text
+static char *trim(char *text)
+{
+    while (*text == ' ' || *text == '\t')
+        text++;
+    int length = strlen(text);
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t'))
+        text[--length] = '\0';
+    return text;
+}
+
+// Check if text starts with prefix, letter case is ignored
+static bool startsWith(char *text, char *prefix)
+{
+    for (; *prefix != '\0'; text++, prefix++)
+    {
+        if (tolower((unsigned char)*text) != *prefix)
+            return false;
+    }
+    return true;
+}
+
+// Finish level if it has rows and set result accordingly
+// Returns false on memory allocation failure, levels are freed then
+static bool finishRows(LevelBuilder *builder, LoadLevelResult *result)
+{
+    if (!hasRows(builder))
+        return true;
+    int finished = finishLevel(builder);
+    if (finished == 4)
+        result->result = 4; // large levels were removed
+    if (finished == 2)
+    {
+        result->result = 2;
+        return false;
+    }
+    return true;
+}
+
+// Read an XML tag after its <, up to and including >
+// Comments are skipped completely, tag is empty then, whitespace outside of quotes becomes space
+// Tag is cut to fit size, the rest is skipped
+// Returns false at end of file
+static bool readTag(FILE *file, char *tag, int size)
+{
+    int length = 0;
+    char quote = 0;
+    int c;
+    while ((c = getc(file)) != EOF)
+    {
+        if (quote == 0 && c == '>')
+        {
+            tag[length] = '\0';
+            return true;
+        }
+        if (quote == 0 && (c == '\n' || c == '\r' || c == '\t')) // attributes can be on separate lines
+            c = ' ';
+        if (quote != 0 && c == quote)
+            quote = 0;
+        else if (quote == 0 && (c == '"' || c == '\''))
+            quote = (char)c;
+        if (length < size - 1)
+            tag[length++] = (char)c;
+
+        if (length == 3 && strncmp(tag, "!--", 3) == 0) // comment, ends with -->, may contain >
+        {
+            int dashes = 0;
+            while ((c = getc(file)) != EOF && !(c == '>' && dashes >= 2))
+                dashes = c == '-' ? dashes + 1 : 0;
+            tag[0] = '\0';
+            return c != EOF;
+        }
+    }
+    return false;
+}
+
+// Replace XML character references and predefined entities in text with UTF-8 characters
+// Text never gets longer, so it is decoded in place
+static void decodeEntities(char *text)
+{
+    static const struct
+    {
+        char *name;
+        char character;
+    } entities[] = {{"amp;", '&'}, {"lt;", '<'}, {"gt;", '>'}, {"quot;", '"'}, {"apos;", '\''}};
+
+    char *out = text;
+    for (char *c = text; *c != '\0';)
+    {
+        if (*c != '&')
+        {
+            *out++ = *c++;
+            continue;
+        }
+        bool decoded = false;
+        if (c[1] == '#') // numeric reference, decimal or hexadecimal
+        {
+            char *end;
+            unsigned long code = c[2] == 'x' ? strtoul(c + 3, &end, 16) : strtoul(c + 2, &end, 10);
+            if (*end == ';' && code > 0 && code <= 0x10FFFF && end - c >= 3)
+            {
+                out += encodeUtf8(code, out);
+                c = end + 1;
+                decoded = true;
+            }
+        }
+        for (int i = 0; i < (int)(sizeof(entities) / sizeof(entities[0])) && !decoded; i++)
+        {
+            if (strncmp(c + 1, entities[i].name, strlen(entities[i].name)) == 0)
+            {
+                *out++ = entities[i].character;
+                c += 1 + strlen(entities[i].name);
+                decoded = true;
+            }
+        }
+        if (!decoded) // not an entity, kept as it is
+            *out++ = *c++;
+    }
+    *out = '\0';
+}
+
+// Get value of attribute of XML tag, like Id in <Level Id="Name">
+// Value is cut to fit size
+// Returns false if tag has no such attribute
+static bool getAttribute(char *tag, char *attribute, char *value, int size)
+{
+    int length = strlen(attribute);
+    for (char *c = strchr(tag, ' '); c != NULL; c = strchr(c + 1, ' '))
+    {
+        char *name = c + 1;
+        while (*name == ' ')
+            name++;
+        if (strncmp(name, attribute, length) != 0)
+            continue;
+        char *equals = name + length;
+        while (*equals == ' ')
+            equals++;
+        if (*equals != '=')
+            continue;
+        char *quote = equals + 1;
+        while (*quote == ' ')
+            quote++;
+        if (*quote != '"' && *quote != '\'')
+            continue;
+        char *end = strchr(quote + 1, *quote);
+        int valueLength = end == NULL ? (int)strlen(quote + 1) : (int)(end - quote - 1);
+        if (valueLength > size - 1)
+            valueLength = size - 1;
+        memcpy(value, quote + 1, valueLength);
+        value[valueLength] = '\0';
+        return true;
+    }
+    return false;
+}
+
+// Check if XML tag has given element name, like L for <L> and /L for </L>
+static bool isElement(char *tag, char *element)
+{
+    int length = strlen(element);
+    return strncmp(tag, element, length) == 0 && (tag[length] == '\0' || tag[length] == ' ' || tag[length] == '/');
+}
+
+// Load levels of an SLC collection, the XML format of most level archives
+// <Level Id="name"> elements contain one <L> element for each row
+// Only the elements needed for levels are looked at, no tree of the document is built
+// Result: same as loadLevel
+LoadLevelResult loadSlc(FILE *file)
+{
+    LoadLevelResult result;
+    result.result = 0;
+    result.level = NULL;
+    LevelBuilder builder;
+    initBuilder(&builder);
+
+    char tag[TAG_SIZE];
+    char row[ROW_SIZE];
+    int rowLength = 0;
+    bool inRow = false;
+    int c;
+    while ((c = getc(file)) != EOF)
+    {
+        if (c != '<')
+        {
+            if (inRow) // text of row, tiles that do not fit make the level too large
+                row[rowLength < ROW_SIZE ? rowLength++ : ROW_SIZE - 1] = normalizeTile((char)c);
+            continue;
+        }
+        if (!readTag(file, tag, TAG_SIZE))
+            break;
+
+        if (isElement(tag, "Level")) // start of level, previous one is finished even if it was not closed
+        {
+            if (!finishRows(&builder, &result))
+                return result;
+            char name[TAG_SIZE];
+            if (getAttribute(tag, "Id", name, TAG_SIZE))
+            {
+                copyName(builder.name, trim(name));
+                decodeEntities(builder.name);
+            }
+        }
+        else if (isElement(tag, "/Level") && !finishRows(&builder, &result))
+            return result;
+        else if (isElement(tag, "L"))
+        {
+            inRow = tag[strlen(tag) - 1] != '/';
+            rowLength = 0;
+            if (!inRow) // <L/> is an empty row
+                addRow(&builder, row, 0);
+        }
+        else if (isElement(tag, "/L") && inRow)
+        {
+            inRow = false;
+            if (!addRow(&builder, row, rowLength))
+            {
+                unloadLevel(builder.first); // free memory and return on faliure
+                result.result = 3;
+                return result;
+            }
+        }
+    }
+
+    if (!finishRows(&builder, &result)) // unclosed last level
+        return result;
+    result.level = builder.first;
+    return result;
+}
+
+// Check if line is a board row of a .sok file
+// Rows may be run length encoded, like 4#|#@$.#, and always contain a wall
+static bool isBoardLine(char *line)
+{
+    if (strchr(line, '#') == NULL)
+        return false;
+    for (char *c = line; *c != '\0'; c++)
+    {
+        if (strchr("#@+$*. -_pPbB0123456789|", *c) == NULL)
+            return false;
+    }
+    return true;
+}
+
+// Add rows of a board line, which may be run length encoded
+// Returns false if a row contains an invalid tile
+static bool addBoardLine(LevelBuilder *builder, char *line)
+{
+    for (char *c = line; *c != '\0'; c++)
+        *c = normalizeTile(*c);
+    return addRleRows(builder, line);
+}
+
+// Load levels of a .sok file
+// Name of level is the text line before its board, or a Title: line after the board
+// Comment blocks, solutions and other Key: value lines are skipped
+// Result: same as loadLevel
+LoadLevelResult loadSok(FILE *file)
+{
+    LoadLevelResult result;
+    result.result = 0;
+    result.level = NULL;
+    LevelBuilder builder;
+    initBuilder(&builder);
+
+    char buffer[LINE_SIZE];
+    char title[64] = ""; // name for next board
+    bool board = false;  // rows of a board are being read
+    bool comment = false;
+    bool solution = false;
+    while (fgets(buffer, LINE_SIZE, file) != NULL)
+    {
+        int length = strlen(buffer);
+        bool cut = length > 0 && buffer[length - 1] != '\n' && !feof(file);
+        while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r'))
+            buffer[--length] = '\0';
+        for (int c = cut ? getc(file) : '\n'; c != '\n' && c != EOF; c = getc(file)) // skip rest of long line
+            ;
+
+        if (comment) // multi-line comment ends with Comment-End:
+        {
+            comment = !startsWith(buffer, "comment-end") && !startsWith(buffer, "comment_end");
+            continue;
+        }
+        if (isBoardLine(buffer))
+        {
+            if (!board) // new board, previous level could be named by Title: until now
+            {
+                if (!finishRows(&builder, &result))
+                    return result;
+                strcpy(builder.name, title);
+                title[0] = '\0';
+                board = true;
+            }
+            if (cut) // board line longer than the buffer cannot fit
+                builder.tooLarge = true;
+            if (!addBoardLine(&builder, buffer))
+            {
+                unloadLevel(builder.first); // free memory and return on faliure
+                result.result = 3;
+                return result;
+            }
+            continue;
+        }
+
+        board = false;
+        char *line = trim(buffer);
+        if (*line == '\0')
+            solution = false; // moves of solution end with an empty line
+        else if (startsWith(line, "title:"))
+            copyName(hasRows(&builder) ? builder.name : title, trim(line + 6)); // title after board names that level
+        else if (startsWith(line, "comment:"))
+            comment = *trim(line + 8) == '\0';
+        else if (startsWith(line, "solution"))
+            solution = true;
+        else if (!solution && !startsWith(line, "::") && !startsWith(line, "author:") && !startsWith(line, "collection:"))
+            copyName(title, line); // text before a board is its name
+    }
+
+    if (!finishRows(&builder, &result))
+        return result;
+    result.level = builder.first;
+    return result;
+}
@@ -0,0 +1,10 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include <stdio.h>
+#include "file.h"
+
+LoadLevelResult loadSlc(FILE *file);
+LoadLevelResult loadSok(FILE *file);
+
+#endif
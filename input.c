@@ -1,5 +1,6 @@
 #include "input.h"
 #include "tiles.h"
+#include "stats.h"
 #include "coordinates.h"
 
 #include <SDL.h>
@@ -14,6 +15,7 @@ typedef struct InputState
     char *enteredText;
     int maxLength;
     bool upperCase;
+    bool altGr; // right alt is held, for characters of Hungarian layout like < and >
     int result;
     SDL_Renderer *renderer;
     SDL_Texture *tiles;
@@ -101,7 +103,7 @@ static void renderInput(InputState *state)
     renderTile(renderer, tiles, wall, 15, 3);
     renderFont(renderer, font, white, state->enteredText, 2, 3, false, true);
 
-    SDL_RenderPresent(renderer);
+    presentFrame(renderer);
 }
 
 // Delete last character of current text
@@ -136,6 +138,9 @@ static bool handleKeydown(InputState *state, SDL_Keycode key)
     case 0xe1: // left shift
         state->upperCase = true;
         return true;
+    case 0xe6: // right alt
+        state->altGr = true;
+        return false;
     case 0x28: // enter
         state->result = 1;
         return false;
@@ -256,11 +261,17 @@ static bool handleKeydown(InputState *state, SDL_Keycode key)
     case 0x31: // ű / Ű
         strcat(state->enteredText, shift ? "ű" : "Ű");
         break;
-    case 0x64: // í / Í
-        strcat(state->enteredText, shift ? "í" : "Í");
+    case 0x64: // í / Í, < with right alt
+        if (state->altGr)
+            strcat(state->enteredText, "<");
+        else
+            strcat(state->enteredText, shift ? "í" : "Í");
         break;
-    case 0x1d: // y / Y
-        strcat(state->enteredText, shift ? "y" : "Y");
+    case 0x1d: // y / Y, > with right alt
+        if (state->altGr)
+            strcat(state->enteredText, ">");
+        else
+            strcat(state->enteredText, shift ? "y" : "Y");
         break;
     case 0x1b: // x / X
         strcat(state->enteredText, shift ? "x" : "X");
@@ -309,6 +320,9 @@ static bool handleKeyup(InputState *state, SDL_Keycode key)
     case 0xe1: // left shift
         state->upperCase = false;
         break;
+    case 0xe6: // right alt
+        state->altGr = false;
+        return false;
     default:
         return false;
         break;
@@ -471,6 +485,7 @@ int textInput(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *
     state.enteredText = enteredText;
     state.maxLength = maxLength;
     state.upperCase = false;
+    state.altGr = false;
     state.result = -1;
 
     // render initialized state
@@ -518,7 +533,7 @@ int alertBox(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *p
     renderTile(renderer, tiles, blankL, 11, 5);
     renderFont(renderer, font, color, "OK", 9, 5, false, true);
 
-    SDL_RenderPresent(renderer);
+    presentFrame(renderer);
 
     SDL_Event ev;
     while (SDL_WaitEvent(&ev))
@@ -576,7 +591,7 @@ int dialogBox(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *
     renderTile(renderer, tiles, blankL, 14, 5);
     renderFont(renderer, font, color, "Mégse", 11, 5, false, true);
 
-    SDL_RenderPresent(renderer);
+    presentFrame(renderer);
 
     SDL_Event ev;
     while (SDL_WaitEvent(&ev))
@@ -0,0 +1,355 @@
+#include "levelindex.h"
+#include "file.h"
+#include "canon.h"
+#include "progress.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+#define MAX_QUERY 63 // longest query, same as the text input of the game
+#define MAX_TERMS 16
+
+// Searched property of level
+typedef enum Field
+{
+    nameF,
+    widthF,
+    heightF,
+    cratesF,
+    targetsF,
+    duplicateF
+} Field;
+
+// One condition of a query, a level matches if it fulfills every term
+typedef struct Term
+{
+    Field field;
+    int min; // numeric fields match values between min and max, both inclusive
+    int max;
+    char *text; // part of name for nameF
+} Term;
+
+// Names of numeric fields in queries, in English and Hungarian
+static const struct
+{
+    char *name;
+    Field field;
+} fieldNames[] = {
+    {"width", widthF},
+    {"szél", widthF},
+    {"szel", widthF},
+    {"height", heightF},
+    {"mag", heightF},
+    {"crates", cratesF},
+    {"láda", cratesF},
+    {"lada", cratesF},
+    {"targets", targetsF},
+    {"cél", targetsF},
+    {"cel", targetsF},
+};
+
+// Hash of canonical form and position of level, sorted to find duplicates
+typedef struct HashPosition
+{
+    unsigned long long hash;
+    int position;
+} HashPosition;
+
+// Convert text to lower case in place, including Hungarian accented letters in UTF-8
+static void foldCase(char *text)
+{
+    for (unsigned char *c = (unsigned char *)text; *c != '\0'; c++)
+    {
+        if (*c >= 'A' && *c <= 'Z')
+            *c += 'a' - 'A';
+        else if (c[0] == 0xC3 && c[1] >= 0x80 && c[1] <= 0x9E && c[1] != 0x97) // Á, É, Í, Ó, Ö, Ú, Ü and other latin letters
+            c[1] += 0x20;
+        else if (c[0] == 0xC5 && (c[1] == 0x90 || c[1] == 0xB0)) // Ő, Ű
+            c[1] += 1;
+    }
+}
+
+// Count crates and targets of level
+static void countTiles(Level *level, IndexEntry *entry)
+{
+    entry->crates = 0;
+    entry->targets = 0;
+    for (int i = 0; i < level->size.x * level->size.y; i++)
+    {
+        TileState tile = level->tiles[i];
+        if (tile == crateS || tile == crateOnTargetS)
+            entry->crates++;
+        if (tile == targetS || tile == crateOnTargetS || tile == playerOnTargetS)
+            entry->targets++;
+    }
+}
+
+// Order by hash for qsort
+static int compareHashes(const void *a, const void *b)
+{
+    unsigned long long x = ((HashPosition *)a)->hash, y = ((HashPosition *)b)->hash;
+    return x < y ? -1 : x > y;
+}
+
+// Mark levels having the same canonical form as another level
+// Returns false on memory allocation failure
+static bool markDuplicates(LevelIndex *index)
+{
+    HashPosition *sorted = (HashPosition *)malloc(sizeof(HashPosition) * index->count);
+    if (sorted == NULL)
+        return false;
+    for (int i = 0; i < index->count; i++)
+    {
+        sorted[i].hash = index->entries[i].hash;
+        sorted[i].position = i;
+    }
+    qsort(sorted, index->count, sizeof(HashPosition), compareHashes);
+    for (int i = 1; i < index->count; i++)
+    {
+        if (sorted[i].hash == sorted[i - 1].hash)
+        {
+            index->entries[sorted[i].position].duplicate = true;
+            index->entries[sorted[i - 1].position].duplicate = true;
+        }
+    }
+    free(sorted);
+    return true;
+}
+
+// Build index of levels in list starting with first
+// Index must be freed with freeIndex even on failure
+// Returns false on memory allocation failure
+bool buildIndex(LevelIndex *index, Level *first)
+{
+    index->entries = NULL;
+    index->count = 0;
+    int count = 0;
+    for (Level *level = first; level != NULL; level = level->next)
+        count++;
+    if (count == 0)
+        return true;
+    index->entries = (IndexEntry *)calloc(count, sizeof(IndexEntry));
+    if (index->entries == NULL)
+        return false;
+
+    for (Level *level = first; level != NULL; level = level->next)
+    {
+        IndexEntry *entry = &index->entries[index->count++];
+        entry->level = level;
+        char *name = level->name == NULL ? "" : level->name;
+        entry->name = (char *)malloc(strlen(name) + 1);
+        if (entry->name == NULL)
+            return false;
+        strcpy(entry->name, name);
+        foldCase(entry->name);
+        entry->width = level->size.x;
+        entry->height = level->size.y;
+        countTiles(level, entry);
+
+        Level *canon = normalizeLevel(level);
+        if (canon == NULL)
+            return false;
+        entry->hash = hashLevel(canon);
+        freeLevel(canon);
+    }
+    return markDuplicates(index);
+}
+
+// Get position of level in index
+// Returns -1 if level is not in the index
+int findEntry(LevelIndex *index, Level *level)
+{
+    for (int i = 0; i < index->count; i++)
+    {
+        if (index->entries[i].level == level)
+            return i;
+    }
+    return -1;
+}
+
+// Read a non-negative number, text is moved after it
+// Returns false if text does not start with a digit
+static bool parseNumber(char **text, int *value)
+{
+    if (**text < '0' || **text > '9')
+        return false;
+    *value = 0;
+    while (**text >= '0' && **text <= '9')
+    {
+        if (*value <= (INT_MAX - 9) / 10)
+            *value = *value * 10 + (**text - '0');
+        (*text)++;
+    }
+    return true;
+}
+
+// Parse comparison of a numeric field, like "crates>8", "láda<=3" or a range like "width=5-10"
+// Length: length of field name, the operator follows it
+// Returns false if term is not a valid comparison
+static bool parseComparison(char *term, int length, Term *parsed)
+{
+    int field = -1;
+    for (int i = 0; i < (int)(sizeof(fieldNames) / sizeof(fieldNames[0])); i++)
+    {
+        if ((int)strlen(fieldNames[i].name) == length && strncmp(fieldNames[i].name, term, length) == 0)
+            field = fieldNames[i].field;
+    }
+    if (field == -1)
+        return false;
+    parsed->field = (Field)field;
+    parsed->min = 0;
+    parsed->max = INT_MAX;
+
+    char *text = term + length;
+    int value;
+    if (text[0] == '=') // exact value or range, either end of range can be left out
+    {
+        text++;
+        bool low = parseNumber(&text, &parsed->min);
+        if (*text != '-')
+        {
+            parsed->max = parsed->min;
+            return low && *text == '\0';
+        }
+        text++;
+        bool high = parseNumber(&text, &parsed->max);
+        return (low || high) && *text == '\0';
+    }
+    bool less = text[0] == '<';
+    bool equal = text[1] == '=';
+    text += equal ? 2 : 1;
+    if (!parseNumber(&text, &value) || *text != '\0')
+        return false;
+    if (less)
+        parsed->max = equal ? value : value - 1;
+    else
+        parsed->min = equal ? value : value + 1;
+    return true;
+}
+
+// Split query to terms separated by spaces
+// Words are parts of name, except "dup" which matches levels with duplicates, and comparisons of numeric fields
+// Query is modified, terms point into it
+// Returns number of terms, -1 if query is invalid
+static int parseQuery(char *query, Term *terms)
+{
+    int count = 0;
+    char *term = query;
+    while (*term != '\0')
+    {
+        if (*term == ' ')
+        {
+            term++;
+            continue;
+        }
+        char *end = strchr(term, ' ');
+        if (end != NULL)
+            *end = '\0';
+        if (count == MAX_TERMS)
+            return -1;
+
+        Term *parsed = &terms[count++];
+        int length = strcspn(term, "<>=");
+        if (term[length] != '\0')
+        {
+            if (!parseComparison(term, length, parsed))
+                return -1;
+        }
+        else if (strcmp(term, "dup") == 0)
+            parsed->field = duplicateF;
+        else
+        {
+            parsed->field = nameF;
+            parsed->text = term;
+        }
+
+        if (end == NULL)
+            break;
+        term = end + 1;
+    }
+    return count;
+}
+
+// Check if numeric value is in range of term
+static bool inRange(Term *term, int value)
+{
+    return value >= term->min && value <= term->max;
+}
+
+// Check if entry fulfills every term
+static bool matchEntry(IndexEntry *entry, Term *terms, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        Term *term = &terms[i];
+        bool match;
+        switch (term->field)
+        {
+        case nameF:
+            match = strstr(entry->name, term->text) != NULL;
+            break;
+        case widthF:
+            match = inRange(term, entry->width);
+            break;
+        case heightF:
+            match = inRange(term, entry->height);
+            break;
+        case cratesF:
+            match = inRange(term, entry->crates);
+            break;
+        case targetsF:
+            match = inRange(term, entry->targets);
+            break;
+        case duplicateF:
+            match = entry->duplicate;
+            break;
+        default:
+            match = false;
+            break;
+        }
+        if (!match)
+            return false;
+    }
+    return true;
+}
+
+// Find next level matching query, searching from the one after position from and wrapping around
+// Query: words of name and filters like "crates>8", see parseQuery, case of letters is ignored
+// From: position of current level, -1 to start at first level
+// Returns position of found level, -1 if no level matches, -2 if query is invalid
+int searchIndex(LevelIndex *index, char *query, int from)
+{
+    if (strlen(query) > MAX_QUERY)
+        return -2;
+    char folded[MAX_QUERY + 1];
+    strcpy(folded, query);
+    foldCase(folded);
+    Term terms[MAX_TERMS];
+    int count = parseQuery(folded, terms);
+    if (count == -1)
+        return -2;
+
+    for (int i = 1; i <= index->count; i++)
+    {
+        int position = (from + i) % index->count;
+        if (matchEntry(&index->entries[position], terms, count))
+            return position;
+    }
+    return -1;
+}
+
+// Free memory used by index
+void freeIndex(LevelIndex *index)
+{
+    for (int i = 0; i < index->count; i++)
+        free(index->entries[i].name);
+    free(index->entries);
+    index->entries = NULL;
+    index->count = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef LEVELINDEX_H
+#define LEVELINDEX_H
+
+#include <stdbool.h>
+#include "file.h"
+
+typedef struct IndexEntry
+{
+    Level *level;
+    char *name; // lower case name for searching
+    int width;
+    int height;
+    int crates;
+    int targets;
+    unsigned long long hash; // hash of canonical form, same for rotated or mirrored copies
+    bool duplicate;          // another level of collection has the same canonical form
+} IndexEntry;
+
+typedef struct LevelIndex
+{
+    IndexEntry *entries; // in order of collection
+    int count;
+} LevelIndex;
+
+bool buildIndex(LevelIndex *index, Level *first);
+int findEntry(LevelIndex *index, Level *level);
+int searchIndex(LevelIndex *index, char *query, int from);
+void freeIndex(LevelIndex *index);
+
+#endif
@@ -0,0 +1,193 @@
+#include "livecheck.h"
+#include "file.h"
+#include "check.h"
+#include "solver.h"
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Background checker of edited level
+// Main thread posts copies of the level, worker thread checks the newest one and reports with an SDL event
+struct LiveCheck
+{
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    Uint32 event;      // event type pushed when result is ready
+    Level *request;    // level waiting to be checked, NULL if there is none
+    int generation;    // number of requests, results of older requests are thrown away
+    LiveResult result; // result of newest request
+    bool quit;
+    atomic_int cancel; // stops solver of outdated request
+    double solveSeconds;
+};
+
+// Copy size and tiles of level, name is not copied
+// Returns NULL on memory allocation failure
+static Level *copyLevel(Level *level)
+{
+    Level *copy = (Level *)malloc(sizeof(Level));
+    if (copy == NULL)
+        return NULL;
+    copy->size = level->size;
+    copy->name = NULL;
+    copy->prev = NULL;
+    copy->next = NULL;
+    copy->tiles = (TileState *)malloc(sizeof(TileState) * level->size.x * level->size.y);
+    if (copy->tiles == NULL)
+    {
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy->tiles, level->tiles, sizeof(TileState) * level->size.x * level->size.y);
+    return copy;
+}
+
+// Check level and try to solve it if no mistakes were found
+static LiveResult runCheck(LiveCheck *live, Level *level)
+{
+    LiveResult result;
+    result.done = true;
+    result.check = checkLevel(level);
+    result.solve = -1;
+    result.pushes = 0;
+    if (result.check.valid && result.check.reachable && result.check.deadCrates <= 0) // -1: dead crates were not checked
+    {
+        SolverLimits limits = {0, live->solveSeconds, &live->cancel, NULL, false};
+        SolverResult solve = solveLevel(level, limits);
+        result.solve = solve.result;
+        result.pushes = solve.pushes;
+        freeSolverResult(&solve);
+    }
+    return result;
+}
+
+// Worker thread, waits for requests until quit is set
+static int liveCheckThread(void *data)
+{
+    LiveCheck *live = (LiveCheck *)data;
+    SDL_LockMutex(live->mutex);
+    while (!live->quit)
+    {
+        if (live->request == NULL)
+        {
+            SDL_CondWait(live->cond, live->mutex);
+            continue;
+        }
+        Level *level = live->request; // take newest request
+        int generation = live->generation;
+        live->request = NULL;
+        atomic_store(&live->cancel, 0);
+        SDL_UnlockMutex(live->mutex);
+
+        LiveResult result = runCheck(live, level); // check without blocking main thread
+        freeLevel(level);
+
+        SDL_LockMutex(live->mutex);
+        if (generation == live->generation) // level was not changed during check
+        {
+            live->result = result;
+            SDL_Event event;
+            memset(&event, 0, sizeof(SDL_Event));
+            event.type = live->event;
+            SDL_PushEvent(&event);
+        }
+    }
+    SDL_UnlockMutex(live->mutex);
+    return 0;
+}
+
+// Start worker thread checking levels
+// SolveSeconds: time limit of solving a level
+// Returns NULL if thread could not be started, levels are not checked then
+LiveCheck *startLiveCheck(double solveSeconds)
+{
+    LiveCheck *live = (LiveCheck *)malloc(sizeof(LiveCheck));
+    if (live == NULL)
+        return NULL;
+    live->request = NULL;
+    live->generation = 0;
+    live->result.done = false;
+    live->quit = false;
+    atomic_init(&live->cancel, 0);
+    live->solveSeconds = solveSeconds;
+    live->event = SDL_RegisterEvents(1);
+    live->mutex = SDL_CreateMutex();
+    live->cond = SDL_CreateCond();
+    live->thread = NULL;
+    if (live->event != (Uint32)-1 && live->mutex != NULL && live->cond != NULL)
+        live->thread = SDL_CreateThread(liveCheckThread, "livecheck", live);
+    if (live->thread == NULL)
+    {
+        if (live->mutex != NULL)
+            SDL_DestroyMutex(live->mutex);
+        if (live->cond != NULL)
+            SDL_DestroyCond(live->cond);
+        free(live);
+        return NULL;
+    }
+    return live;
+}
+
+// Get type of SDL event that is pushed when a check is finished
+Uint32 liveCheckEvent(LiveCheck *live)
+{
+    return live == NULL ? (Uint32)-1 : live->event;
+}
+
+// Request check of level, check of previous level is cancelled
+// Level is copied, so it can be modified after the call
+// NULL level clears the result
+void requestLiveCheck(LiveCheck *live, Level *level)
+{
+    if (live == NULL)
+        return;
+    Level *copy = level == NULL ? NULL : copyLevel(level);
+
+    SDL_LockMutex(live->mutex);
+    freeLevel(live->request); // older request is not needed anymore
+    live->request = copy;
+    live->generation++;
+    live->result.done = false;
+    atomic_store(&live->cancel, 1);
+    SDL_CondSignal(live->cond);
+    SDL_UnlockMutex(live->mutex);
+}
+
+// Get result of newest request
+LiveResult getLiveResult(LiveCheck *live)
+{
+    LiveResult result;
+    result.done = false;
+    if (live == NULL)
+        return result;
+    SDL_LockMutex(live->mutex);
+    result = live->result;
+    SDL_UnlockMutex(live->mutex);
+    return result;
+}
+
+// Stop worker thread and free checker
+void stopLiveCheck(LiveCheck *live)
+{
+    if (live == NULL)
+        return;
+    SDL_LockMutex(live->mutex);
+    live->quit = true;
+    atomic_store(&live->cancel, 1);
+    SDL_CondSignal(live->cond);
+    SDL_UnlockMutex(live->mutex);
+
+    SDL_WaitThread(live->thread, NULL);
+    freeLevel(live->request);
+    SDL_DestroyMutex(live->mutex);
+    SDL_DestroyCond(live->cond);
+    free(live);
+}
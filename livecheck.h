@@ -0,0 +1,25 @@
+#ifndef LIVECHECK_H
+#define LIVECHECK_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "file.h"
+#include "check.h"
+
+typedef struct LiveResult
+{
+    bool done; // false while level is being checked
+    LevelCheck check;
+    int solve;  // solver result, -1 if solving was not attempted
+    int pushes; // pushes of solution
+} LiveResult;
+
+typedef struct LiveCheck LiveCheck;
+
+LiveCheck *startLiveCheck(double solveSeconds);
+Uint32 liveCheckEvent(LiveCheck *live);
+void requestLiveCheck(LiveCheck *live, Level *level);
+LiveResult getLiveResult(LiveCheck *live);
+void stopLiveCheck(LiveCheck *live);
+
+#endif
@@ -2,6 +2,7 @@
 #include <SDL_image.h>
 #include <SDL_ttf.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include "menu.h"
@@ -9,15 +10,18 @@
 #include "play.h"
 #include "edit.h"
 #include "input.h"
+#include "stats.h"
+#include "assets.h"
+#include "preload.h"
 
 #ifdef DEBUGMALLOC
 #include "debugmalloc.h"
 #endif
 
-// Initialize SDL. Returns renderer pointer on success, returns NULL on faliure
+// Initialize SDL video. Returns renderer pointer on success, returns NULL on faliure
 SDL_Renderer *initSDL()
 {
-    if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) // audio, joystick and the others are not used
     {
         return NULL;
     }
@@ -31,39 +35,80 @@ SDL_Renderer *initSDL()
     return renderer;
 }
 
+// Decode tiles image while the window is created
+static int decodeThread(void *data)
+{
+    *(SDL_Surface **)data = decodeTiles();
+    return 0;
+}
+
+// Open font while the window is created
+static int fontThread(void *data)
+{
+    *(TTF_Font **)data = loadFont(50);
+    return 0;
+}
+
+// Wait for a startup thread, or run its work here if the thread could not be created
+static void finishThread(SDL_Thread *thread, SDL_ThreadFunction function, void *data)
+{
+    if (thread != NULL)
+        SDL_WaitThread(thread, NULL);
+    else
+        function(data);
+}
+
 // Main program function
 // Return values: 0 - success, 1 - SDL init error, 2 - SDL_Image error, 3 - TTF_Font error
 int main(void)
 {
+    Uint64 start = SDL_GetPerformanceCounter(); // for time to first frame
+
+    char filename[64];
+    if (!readLastFile(filename, sizeof(filename))) // menu offers the last collection
+        filename[0] = '\0';
+    else
+        startPreload(filename);
+
+    // assets are decoded and the collection parsed while the window opens
+    SDL_Surface *surface = NULL;
+    SDL_Thread *decoder = SDL_CreateThread(decodeThread, "tiles", &surface);
+    TTF_Font *font = NULL;
+    bool ttf = TTF_Init() == 0;
+    SDL_Thread *opener = ttf ? SDL_CreateThread(fontThread, "font", &font) : NULL;
+
     SDL_Renderer *renderer = initSDL();
+    finishThread(decoder, decodeThread, &surface);
+    if (ttf)
+        finishThread(opener, fontThread, &font);
     if (renderer == NULL)
     {
         printf("ERROR: Couldn't initialize SDL\n");
         return 1;
     }
 
-    SDL_Texture *tiles = IMG_LoadTexture(renderer, "tiles.png");
+    SDL_Texture *tiles = surface == NULL ? NULL : SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
     if (tiles == NULL)
     {
         printf("ERROR: Couldn't load tiles texture\n");
         return 2;
     }
 
-    TTF_Init();
-    TTF_Font *font = TTF_OpenFont("font.ttf", 50);
     if (!font)
     {
         printf("ERROR: Couldn't open font\n");
         return 3;
     }
 
-    int result;
-    char filename[64];
-    filename[0] = '\0';
+    initStats(font, start); // only if SOKOBAN_STATS is set
 
+    int result;
     do
     {
         result = mainMenu(renderer, tiles, font, filename);
+        if (result == 1 || result == 2)
+            writeLastFile(filename);
         switch (result)
         {
         case 1:
@@ -77,9 +122,11 @@ int main(void)
         }
     } while (result != 0);
 
+    reportStats();
+    stopPreload(); // collection may not have been opened
     SDL_DestroyTexture(tiles);
     TTF_CloseFont(font);
     SDL_Quit();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #include "menu.h"
 #include "tiles.h"
+#include "stats.h"
 #include "coordinates.h"
 #include "input.h"
 
@@ -83,7 +84,7 @@ static void renderMenu(MenuState *state)
 
     renderFont(renderer, font, color, "Told a ládát a megfelelő opció előtti célra!", 0, 11, false, true);
 
-    SDL_RenderPresent(renderer);
+    presentFrame(renderer);
 }
 
 // Process current position of crate and set menu result accordingly
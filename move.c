@@ -0,0 +1,127 @@
+#include "move.h"
+#include "file.h"
+#include "coordinates.h"
+
+#include <stdbool.h>
+
+// Coordinate offsets for each direction
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+// Get tile at coordinates
+// Returns invalidS for tiles outside of play area
+static TileState getTileState(Level *level, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= level->size.x || y >= level->size.y)
+    {
+        return invalidS;
+    }
+    return level->tiles[x + y * level->size.x];
+}
+
+// Set state of tile at coordinates
+// Does nothing for tiles outside of play area
+static void setTileState(Level *level, int x, int y, TileState state)
+{
+    if (x < 0 || y < 0 || x >= level->size.x || y >= level->size.y)
+    {
+        return;
+    }
+    level->tiles[x + y * level->size.x] = state;
+}
+
+// Move player in given direction, pushing crate in front of player if possible
+// Level must not contain player tile, player position is stored separately
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+// Returns blockedM if player cannot move, walkedM on simple move and pushedM if a crate was pushed
+MoveResult movePlayer(Level *level, Coordinates *player, int dir)
+{
+    if (dir < 0 || dir > 3)
+        return blockedM;
+
+    int x1 = player->x + dirX[dir]; // tile in front of player
+    int y1 = player->y + dirY[dir];
+    int x2 = x1 + dirX[dir]; // tile behind crate
+    int y2 = y1 + dirY[dir];
+    TileState front = getTileState(level, x1, y1);
+
+    if (front == crateS || front == crateOnTargetS) // crate in front of player
+    {
+        TileState behind = getTileState(level, x2, y2);
+        if (behind == floorTileS || behind == targetS) // crate can move
+        {
+            setTileState(level, x1, y1, front == crateS ? floorTileS : targetS);    // replace crate with what is under it
+            setTileState(level, x2, y2, behind == floorTileS ? crateS : crateOnTargetS); // place crate
+            player->x = x1;                                                          // move player
+            player->y = y1;
+            return pushedM;
+        }
+        return blockedM;
+    }
+    if (front == floorTileS || front == targetS) // player can move
+    {
+        player->x = x1; // move player
+        player->y = y1;
+        return walkedM;
+    }
+    return blockedM;
+}
+
+// Reverse a move made by movePlayer
+// Push: the move pushed a crate, it is pulled back to the tile the player leaves
+// Move must be the last one made, otherwise the level gets corrupted
+void revertMove(Level *level, Coordinates *player, int dir, bool push)
+{
+    if (dir < 0 || dir > 3)
+        return;
+
+    if (push)
+    {
+        int x = player->x + dirX[dir]; // crate in front of player
+        int y = player->y + dirY[dir];
+        TileState crate = getTileState(level, x, y);
+        TileState under = getTileState(level, player->x, player->y);
+        setTileState(level, x, y, crate == crateOnTargetS ? targetS : floorTileS);
+        setTileState(level, player->x, player->y, under == targetS ? crateOnTargetS : crateS);
+    }
+    player->x -= dirX[dir]; // step back
+    player->y -= dirY[dir];
+}
+
+// Extract player position and replace tile under player
+// Returns false if level does not contain player
+bool takePlayer(Level *level, Coordinates *player)
+{
+    bool found = false;
+    for (int i = 0; i < level->size.x; i++)
+    {
+        for (int j = 0; j < level->size.y; j++)
+        {
+            TileState tile = getTileState(level, i, j);
+            if (tile == playerS || tile == playerOnTargetS)
+            {
+                player->x = i;
+                player->y = j;
+                setTileState(level, i, j, tile == playerS ? floorTileS : targetS);
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+// Check if all targets are covered by crates
+// Returns true if ^ true
+bool levelFinished(Level *level)
+{
+    for (int i = 0; i < level->size.x * level->size.y; i++)
+    {
+        TileState tile = level->tiles[i];
+        if (tile == targetS || tile == playerOnTargetS)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <stdbool.h>
+#include "file.h"
+#include "coordinates.h"
+
+typedef enum MoveResult
+{
+    blockedM = 0,
+    walkedM,
+    pushedM
+} MoveResult;
+
+MoveResult movePlayer(Level *level, Coordinates *player, int dir);
+void revertMove(Level *level, Coordinates *player, int dir, bool push);
+bool takePlayer(Level *level, Coordinates *player);
+bool levelFinished(Level *level);
+
+#endif
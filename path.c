@@ -0,0 +1,271 @@
+#include "path.h"
+#include "file.h"
+#include "coordinates.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Coordinate offsets for each direction
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+// Check if player can stand on tile at coordinates, which is also where a crate can be pushed
+// Returns false for tiles outside of play area
+static bool isWalkable(Level *level, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= level->size.x || y >= level->size.y)
+        return false;
+    TileState tile = level->tiles[x + y * level->size.x];
+    return tile == floorTileS || tile == targetS || tile == playerS || tile == playerOnTargetS;
+}
+
+// Find shortest walking path between two tiles, crates are not pushed
+// Moves are written to moves array, direction: 0 - left, 1 - up, 2 - right, 3 - down
+// Returns number of moves on success, -1 if target is unreachable or path is longer than maxMoves,
+// -2 on memory allocation failure
+int findPath(Level *level, Coordinates from, Coordinates to, int *moves, int maxMoves)
+{
+    if (!isWalkable(level, to.x, to.y) || !isWalkable(level, from.x, from.y))
+        return -1;
+
+    int count = level->size.x * level->size.y;
+    int *queue = (int *)malloc(sizeof(int) * count);    // breadth first search queue of tile indexes
+    signed char *came = (signed char *)malloc(count); // direction used to reach each tile, -1 if not yet reached
+    if (queue == NULL || came == NULL)
+    {
+        free(queue);
+        free(came);
+        return -2;
+    }
+    for (int i = 0; i < count; i++)
+        came[i] = -1;
+
+    int start = from.x + from.y * level->size.x;
+    int goal = to.x + to.y * level->size.x;
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = start;
+    came[start] = 4; // start tile is reached without a move
+
+    while (head < tail && came[goal] == -1) // while there are tiles to visit and goal is not reached
+    {
+        int current = queue[head++];
+        int x = current % level->size.x;
+        int y = current / level->size.x;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int nx = x + dirX[dir];
+            int ny = y + dirY[dir];
+            if (isWalkable(level, nx, ny) && came[nx + ny * level->size.x] == -1)
+            {
+                came[nx + ny * level->size.x] = dir;
+                queue[tail++] = nx + ny * level->size.x;
+            }
+        }
+    }
+
+    int length = -1;
+    if (came[goal] != -1) // walk backwards from goal to count path length
+    {
+        length = 0;
+        for (int i = goal; i != start; i -= dirX[(int)came[i]] + dirY[(int)came[i]] * level->size.x)
+            length++;
+        if (length > maxMoves)
+            length = -1;
+        else
+        {
+            int index = length;
+            for (int i = goal; i != start; i -= dirX[(int)came[i]] + dirY[(int)came[i]] * level->size.x) // fill moves from the end
+                moves[--index] = came[i];
+        }
+    }
+
+    free(queue);
+    free(came);
+    return length;
+}
+
+// Label tiles reachable by player with crate standing on given tile
+// Tiles in the same area get the same label, unreachable tiles and the crate get -1
+// Level tiles must not contain the pushed crate
+static void labelAreas(Level *level, int crate, short *labels, int *queue)
+{
+    int count = level->size.x * level->size.y;
+    for (int i = 0; i < count; i++)
+        labels[i] = -1;
+
+    short label = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (i == crate || labels[i] != -1 || !isWalkable(level, i % level->size.x, i / level->size.x))
+            continue;
+        int head = 0;
+        int tail = 0;
+        queue[tail++] = i;
+        labels[i] = label;
+        while (head < tail) // fill area of tile
+        {
+            int current = queue[head++];
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int nx = current % level->size.x + dirX[dir];
+                int ny = current / level->size.x + dirY[dir];
+                int next = nx + ny * level->size.x;
+                if (isWalkable(level, nx, ny) && next != crate && labels[next] == -1)
+                {
+                    labels[next] = label;
+                    queue[tail++] = next;
+                }
+            }
+        }
+        label++;
+    }
+}
+
+// Get reachability labels for crate standing on given tile
+// Labels are computed once per crate tile and cached in areas
+static short *getAreas(Level *level, int crate, short *areas, bool *cached, int *queue)
+{
+    int count = level->size.x * level->size.y;
+    if (!cached[crate])
+    {
+        labelAreas(level, crate, areas + crate * count, queue);
+        cached[crate] = true;
+    }
+    return areas + crate * count;
+}
+
+// Append walking path and push to end of moves array
+// Returns false if walking path does not exist
+static bool appendPush(Level *level, int crate, int player, int dir, int *moves, int *length)
+{
+    int count = level->size.x * level->size.y;
+    Coordinates from = {player % level->size.x, player / level->size.x};
+    Coordinates to = {crate % level->size.x - dirX[dir], crate / level->size.x - dirY[dir]};
+
+    TileState under = level->tiles[crate];
+    level->tiles[crate] = crateS; // crate blocks walking path
+    int walk = findPath(level, from, to, moves + *length, count);
+    level->tiles[crate] = under;
+    if (walk < 0)
+        return false;
+    *length += walk;
+    moves[(*length)++] = dir;
+    return true;
+}
+
+// Find shortest sequence of pushes moving a crate to target tile
+// Walking moves of player between pushes are included, other crates are not moved
+// Moves array is dinamically allocated, so must be freed after use, direction: 0 - left, 1 - up, 2 - right, 3 - down
+// Returns number of moves on success, -1 if crate cannot be pushed to target, -2 on memory allocation failure
+int findPushPath(Level *level, Coordinates player, Coordinates from, Coordinates to, int **moves)
+{
+    *moves = NULL;
+    if (from.x < 0 || from.y < 0 || from.x >= level->size.x || from.y >= level->size.y)
+        return -1;
+    int count = level->size.x * level->size.y;
+    int start = from.x + from.y * level->size.x;
+    int goal = to.x + to.y * level->size.x;
+    TileState crateTile = level->tiles[start];
+    if ((crateTile != crateS && crateTile != crateOnTargetS) || !isWalkable(level, to.x, to.y))
+        return -1;
+    if (start == goal)
+        return 0;
+
+    // search state is crate tile and side of player next to crate: state = tile * 4 + side
+    // last state is the starting position, where player is not necessarily next to crate
+    int states = count * 4 + 1;
+    short *areas = (short *)malloc(sizeof(short) * count * count); // cached reachability labels per crate tile
+    bool *cached = (bool *)calloc(count, sizeof(bool));
+    int *queue = (int *)malloc(sizeof(int) * (states > count ? states : count));
+    int *parent = (int *)malloc(sizeof(int) * states); // previous state, -1 if not yet reached
+    int *tileQueue = (int *)malloc(sizeof(int) * count);
+    if (areas == NULL || cached == NULL || queue == NULL || parent == NULL || tileQueue == NULL)
+    {
+        free(areas);
+        free(cached);
+        free(queue);
+        free(parent);
+        free(tileQueue);
+        return -2;
+    }
+    for (int i = 0; i < states; i++)
+        parent[i] = -1;
+
+    level->tiles[start] = crateTile == crateS ? floorTileS : targetS; // pushed crate is tracked by search, not by tiles
+
+    int head = 0;
+    int tail = 0;
+    int found = -1;
+    queue[tail++] = states - 1;
+    parent[states - 1] = states - 1;
+    while (head < tail && found == -1) // breadth first search over pushes
+    {
+        int current = queue[head++];
+        int crate = current == states - 1 ? start : current / 4;
+        int playerTile = current == states - 1 ? player.x + player.y * level->size.x : crate + dirX[current % 4] + dirY[current % 4] * level->size.x;
+        short *labels = getAreas(level, crate, areas, cached, tileQueue);
+        int x = crate % level->size.x;
+        int y = crate / level->size.x;
+
+        for (int dir = 0; dir < 4 && found == -1; dir++)
+        {
+            // player stands behind crate, crate moves in push direction
+            if (!isWalkable(level, x - dirX[dir], y - dirY[dir]) || !isWalkable(level, x + dirX[dir], y + dirY[dir]))
+                continue;
+            if (labels[playerTile] == -1 || labels[playerTile] != labels[x - dirX[dir] + (y - dirY[dir]) * level->size.x])
+                continue;
+            int next = (x + dirX[dir] + (y + dirY[dir]) * level->size.x) * 4 + (dir + 2) % 4; // player ends up on opposite side
+            if (parent[next] != -1)
+                continue;
+            parent[next] = current;
+            queue[tail++] = next;
+            if (next / 4 == goal)
+                found = next;
+        }
+    }
+
+    int length = -1;
+    if (found != -1)
+    {
+        int pushes = 0; // collect states of path in reverse order
+        for (int i = found; i != states - 1; i = parent[i])
+            queue[pushes++] = i;
+
+        *moves = (int *)malloc(sizeof(int) * pushes * (count + 1)); // every push is preceded by a walk of at most count moves
+        if (*moves == NULL)
+            length = -2;
+        else
+        {
+            length = 0;
+            int crate = start;
+            int playerTile = player.x + player.y * level->size.x;
+            for (int i = pushes - 1; i >= 0 && length >= 0; i--)
+            {
+                int dir = (queue[i] % 4 + 2) % 4; // push direction is opposite of player side
+                if (!appendPush(level, crate, playerTile, dir, *moves, &length))
+                    length = -1;
+                playerTile = crate;
+                crate = queue[i] / 4;
+            }
+            if (length < 0)
+            {
+                free(*moves);
+                *moves = NULL;
+            }
+        }
+    }
+
+    level->tiles[start] = crateTile; // restore crate
+    free(areas);
+    free(cached);
+    free(queue);
+    free(parent);
+    free(tileQueue);
+    return length;
+}
@@ -0,0 +1,10 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "file.h"
+#include "coordinates.h"
+
+int findPath(Level *level, Coordinates from, Coordinates to, int *moves, int maxMoves);
+int findPushPath(Level *level, Coordinates player, Coordinates from, Coordinates to, int **moves);
+
+#endif
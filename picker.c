@@ -0,0 +1,552 @@
+#include "picker.h"
+#include "file.h"
+#include "tiles.h"
+#include "stats.h"
+#include "assets.h"
+#include "input.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+#define THUMB_W 184      // size of a thumbnail in pixels, a grid cell is 3 x 2 blocks
+#define THUMB_H 120
+#define MAX_SCALE 16     // pixels per level tile, small levels are not blown up further
+#define ATLAS_COLUMNS 10 // thumbnails in a row of the atlas texture
+#define ATLAS_ROWS 16
+#define SLOTS (ATLAS_COLUMNS * ATLAS_ROWS)
+#define GRID_COLUMNS 6   // cells on screen, grid starts at block 1, 0
+#define GRID_ROWS 5
+#define QUEUE_SIZE (GRID_COLUMNS * (GRID_ROWS + 1)) // visible levels and the row below them
+
+// Thumbnail cache of level picker
+// Worker thread draws requested levels to surfaces, main thread copies them into slots of one atlas texture
+// Slots are reused for other levels when the atlas is full, least recently drawn first
+struct Thumbnails
+{
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    Uint32 event;             // event type pushed when a thumbnail is ready
+    SDL_Surface *art;         // decoded tiles image, only used by worker thread
+    SDL_Texture *atlas;       // only used by main thread
+    Level *slots[SLOTS];      // level shown in each slot of atlas, NULL if slot is free
+    Uint32 used[SLOTS];       // frame slot was last drawn in
+    Uint32 frame;             // number of rendered picker frames
+    Level *queue[QUEUE_SIZE]; // levels waiting to be drawn, worker takes them from the front
+    int queued;
+    Level *drawing;           // level drawn by worker right now, NULL if it is idle
+    Level *ready[QUEUE_SIZE]; // drawn levels not copied to atlas yet
+    SDL_Surface *readySurfaces[QUEUE_SIZE];
+    int readyCount;
+    bool quit;
+};
+
+// Current state of level picker
+typedef struct PickerState
+{
+    Level **levels; // levels of collection in order
+    int count;
+    int selected; // index of highlighted level
+    int top;      // first visible row of grid
+    int result;
+    Thumbnails *thumbnails;
+    SDL_Renderer *renderer;
+    SDL_Texture *tiles;
+    TTF_Font *font;
+} PickerState;
+
+// Convert ot tileState to tile
+// Returns brown floor on error
+static Tile tileStateToTile(TileState state)
+{
+    switch (state)
+    {
+    case wallS:
+        return wall;
+    case playerS:
+        return player;
+    case playerOnTargetS:
+        return player;
+    case crateS:
+        return crate;
+    case crateOnTargetS:
+        return crateOnTarget;
+    case targetS:
+        return target;
+    case floorTileS:
+        return brownFloor;
+    default:
+        return brownFloor;
+    }
+}
+
+// Copy tile scaled down to position of thumbnail
+static void drawTile(SDL_Surface *art, SDL_Surface *surface, Tile tile, int x, int y, int scale)
+{
+    SDL_Rect src = toSourceRect(tile);
+    SDL_Rect dst = {x, y, scale, scale};
+    SDL_BlitScaled(art, &src, surface, &dst);
+}
+
+// Draw miniature of level, centered on a transparent background
+// Safe to call from worker thread, it does not use the renderer
+// Returns NULL on memory allocation failure
+static SDL_Surface *drawThumbnail(SDL_Surface *art, Level *level)
+{
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, THUMB_W, THUMB_H, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL)
+        return NULL;
+
+    int scale = THUMB_W / level->size.x < THUMB_H / level->size.y ? THUMB_W / level->size.x : THUMB_H / level->size.y;
+    if (scale > MAX_SCALE)
+        scale = MAX_SCALE;
+    if (scale < 1) // too big levels are cut off
+        scale = 1;
+    int startX = (THUMB_W - level->size.x * scale) / 2;
+    int startY = (THUMB_H - level->size.y * scale) / 2;
+
+    for (int i = 0; i < level->size.x; i++)
+    {
+        for (int j = 0; j < level->size.y; j++)
+        {
+            TileState tileState = level->tiles[i + j * level->size.x];
+            if (tileState == invalidS) // outside of level stays transparent
+                continue;
+            int x = startX + i * scale;
+            int y = startY + j * scale;
+            drawTile(art, surface, brownFloor, x, y, scale);
+            if (tileState == playerOnTargetS)
+                drawTile(art, surface, target, x, y, scale);
+            if (tileState != floorTileS)
+                drawTile(art, surface, tileStateToTile(tileState), x, y, scale);
+        }
+    }
+    return surface;
+}
+
+// Worker thread, draws queued levels until quit is set
+static int thumbnailThread(void *data)
+{
+    Thumbnails *thumbnails = (Thumbnails *)data;
+    SDL_LockMutex(thumbnails->mutex);
+    while (!thumbnails->quit)
+    {
+        if (thumbnails->queued == 0)
+        {
+            SDL_CondWait(thumbnails->cond, thumbnails->mutex);
+            continue;
+        }
+        Level *level = thumbnails->queue[0]; // take first request
+        thumbnails->queued--;
+        memmove(thumbnails->queue, thumbnails->queue + 1, sizeof(Level *) * thumbnails->queued);
+        thumbnails->drawing = level;
+        SDL_UnlockMutex(thumbnails->mutex);
+
+        SDL_Surface *surface = drawThumbnail(thumbnails->art, level); // draw without blocking main thread
+
+        SDL_LockMutex(thumbnails->mutex);
+        thumbnails->drawing = NULL;
+        if (surface != NULL && thumbnails->readyCount < QUEUE_SIZE)
+        {
+            thumbnails->ready[thumbnails->readyCount] = level;
+            thumbnails->readySurfaces[thumbnails->readyCount] = surface;
+            thumbnails->readyCount++;
+            SDL_Event event;
+            memset(&event, 0, sizeof(SDL_Event));
+            event.type = thumbnails->event;
+            SDL_PushEvent(&event);
+        }
+        else // failed ones are requested again on next render
+            SDL_FreeSurface(surface);
+        SDL_CondBroadcast(thumbnails->cond); // main thread may wait for worker to become idle
+    }
+    SDL_UnlockMutex(thumbnails->mutex);
+    return 0;
+}
+
+// Start worker thread drawing thumbnails
+// Returns NULL if thumbnails cannot be drawn, picker works without them then
+Thumbnails *startThumbnails(SDL_Renderer *renderer)
+{
+    Thumbnails *thumbnails = (Thumbnails *)malloc(sizeof(Thumbnails));
+    if (thumbnails == NULL)
+        return NULL;
+    memset(thumbnails, 0, sizeof(Thumbnails));
+    thumbnails->event = SDL_RegisterEvents(1);
+    thumbnails->art = decodeTiles(); // worker cannot use the tiles texture of the renderer
+    thumbnails->atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, ATLAS_COLUMNS * THUMB_W, ATLAS_ROWS * THUMB_H);
+    thumbnails->mutex = SDL_CreateMutex();
+    thumbnails->cond = SDL_CreateCond();
+    if (thumbnails->event != (Uint32)-1 && thumbnails->art != NULL && thumbnails->atlas != NULL && thumbnails->mutex != NULL && thumbnails->cond != NULL)
+        thumbnails->thread = SDL_CreateThread(thumbnailThread, "thumbnails", thumbnails);
+    if (thumbnails->thread == NULL)
+    {
+        SDL_FreeSurface(thumbnails->art);
+        if (thumbnails->atlas != NULL)
+            SDL_DestroyTexture(thumbnails->atlas);
+        if (thumbnails->mutex != NULL)
+            SDL_DestroyMutex(thumbnails->mutex);
+        if (thumbnails->cond != NULL)
+            SDL_DestroyCond(thumbnails->cond);
+        free(thumbnails);
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(thumbnails->atlas, SDL_BLENDMODE_BLEND); // background shows around levels
+    return thumbnails;
+}
+
+// Get slot of atlas showing level
+// Returns -1 if level has no thumbnail yet
+static int findSlot(Thumbnails *thumbnails, Level *level)
+{
+    for (int i = 0; i < SLOTS; i++)
+    {
+        if (thumbnails->slots[i] == level)
+            return i;
+    }
+    return -1;
+}
+
+// Copy thumbnails drawn by worker into the atlas
+// Slots drawn least recently are reused when atlas is full, visible ones are never taken
+static void uploadReady(Thumbnails *thumbnails)
+{
+    SDL_LockMutex(thumbnails->mutex);
+    for (int i = 0; i < thumbnails->readyCount; i++)
+    {
+        Level *level = thumbnails->ready[i];
+        SDL_Surface *surface = thumbnails->readySurfaces[i];
+        int slot = findSlot(thumbnails, level);
+        for (int j = 0; j < SLOTS && slot == -1; j++) // free slot
+        {
+            if (thumbnails->slots[j] == NULL)
+                slot = j;
+        }
+        for (int j = 0; j < SLOTS && slot == -1; j++) // least recently drawn slot
+        {
+            if (thumbnails->used[j] != thumbnails->frame && (slot == -1 || thumbnails->used[j] < thumbnails->used[slot]))
+                slot = j;
+        }
+        if (slot != -1)
+        {
+            SDL_Rect rect = {slot % ATLAS_COLUMNS * THUMB_W, slot / ATLAS_COLUMNS * THUMB_H, THUMB_W, THUMB_H};
+            SDL_UpdateTexture(thumbnails->atlas, &rect, surface->pixels, surface->pitch);
+            thumbnails->slots[slot] = level;
+            thumbnails->used[slot] = thumbnails->frame;
+        }
+        SDL_FreeSurface(surface);
+    }
+    thumbnails->readyCount = 0;
+    SDL_UnlockMutex(thumbnails->mutex);
+}
+
+// Throw away queued requests and wait until worker finishes the level it is drawing
+// Levels may be modified or freed after this
+static void waitIdle(Thumbnails *thumbnails)
+{
+    SDL_LockMutex(thumbnails->mutex);
+    thumbnails->queued = 0;
+    while (thumbnails->drawing != NULL)
+        SDL_CondWait(thumbnails->cond, thumbnails->mutex);
+    SDL_UnlockMutex(thumbnails->mutex);
+    uploadReady(thumbnails);
+}
+
+// Forget every thumbnail, used when levels were changed since picker was last open
+// Must not be called while picker is open
+void clearThumbnails(Thumbnails *thumbnails)
+{
+    if (thumbnails == NULL)
+        return;
+    for (int i = 0; i < SLOTS; i++)
+        thumbnails->slots[i] = NULL;
+}
+
+// Stop worker thread and free thumbnails
+void stopThumbnails(Thumbnails *thumbnails)
+{
+    if (thumbnails == NULL)
+        return;
+    SDL_LockMutex(thumbnails->mutex);
+    thumbnails->quit = true;
+    SDL_CondBroadcast(thumbnails->cond);
+    SDL_UnlockMutex(thumbnails->mutex);
+
+    SDL_WaitThread(thumbnails->thread, NULL);
+    for (int i = 0; i < thumbnails->readyCount; i++)
+        SDL_FreeSurface(thumbnails->readySurfaces[i]);
+    SDL_FreeSurface(thumbnails->art);
+    SDL_DestroyTexture(thumbnails->atlas);
+    SDL_DestroyMutex(thumbnails->mutex);
+    SDL_DestroyCond(thumbnails->cond);
+    free(thumbnails);
+}
+
+// Replace queued requests with visible levels that have no thumbnail yet, and the row below them
+// Requests are drawn in order, top left first
+static void requestVisible(PickerState *state)
+{
+    Thumbnails *thumbnails = state->thumbnails;
+    SDL_LockMutex(thumbnails->mutex);
+    thumbnails->queued = 0;
+    int first = state->top * GRID_COLUMNS;
+    for (int i = first; i < state->count && i < first + QUEUE_SIZE; i++)
+    {
+        Level *level = state->levels[i];
+        if (level != thumbnails->drawing && findSlot(thumbnails, level) == -1)
+            thumbnails->queue[thumbnails->queued++] = level;
+    }
+    if (thumbnails->queued > 0)
+        SDL_CondBroadcast(thumbnails->cond);
+    SDL_UnlockMutex(thumbnails->mutex);
+}
+
+// Render grid of visible levels to renderer
+// Thumbnails not drawn yet are left empty, they appear when worker finishes them
+static void renderPicker(PickerState *state)
+{
+    SDL_Renderer *renderer = state->renderer;
+    SDL_Texture *tiles = state->tiles;
+    TTF_Font *font = state->font;
+    Thumbnails *thumbnails = state->thumbnails;
+
+    SDL_RenderClear(renderer);
+
+    SDL_Color white = {255, 255, 255, 255};
+    renderTiles(renderer, tiles, greyFloor, 0, 0, 19, 11);
+
+    if (thumbnails != NULL)
+        thumbnails->frame++;
+    for (int row = 0; row < GRID_ROWS; row++) // only visible rows are drawn
+    {
+        for (int column = 0; column < GRID_COLUMNS; column++)
+        {
+            int index = (state->top + row) * GRID_COLUMNS + column;
+            if (index >= state->count)
+                break;
+            int x = 1 + column * 3;
+            int y = row * 2;
+            if (index == state->selected)
+                renderTiles(renderer, tiles, greenFloor, x, y, x + 2, y + 1);
+            int slot = thumbnails == NULL ? -1 : findSlot(thumbnails, state->levels[index]);
+            if (slot != -1)
+            {
+                SDL_Rect src = {slot % ATLAS_COLUMNS * THUMB_W, slot / ATLAS_COLUMNS * THUMB_H, THUMB_W, THUMB_H};
+                SDL_Rect dst = {x * 64 + (192 - THUMB_W) / 2, y * 64 + (128 - THUMB_H) / 2, THUMB_W, THUMB_H};
+                SDL_RenderCopy(renderer, thumbnails->atlas, &src, &dst);
+                countCopy();
+                thumbnails->used[slot] = thumbnails->frame;
+            }
+        }
+    }
+
+    // control buttons
+    renderTile(renderer, tiles, home, 0, 0);
+    if (state->top > 0)
+        renderTile(renderer, tiles, up, 19, 0);
+    if ((state->top + GRID_ROWS) * GRID_COLUMNS < state->count)
+        renderTile(renderer, tiles, down, 19, 9);
+
+    char position[32];
+    sprintf(position, "%d / %d", state->selected + 1, state->count);
+    renderFont(renderer, font, white, position, 10, 10, true, true);
+    renderFont(renderer, font, white, state->levels[state->selected]->name, 10, 11, true, true); // level name
+
+    presentFrame(renderer);
+
+    if (thumbnails != NULL)
+        requestVisible(state);
+}
+
+// Get number of rows needed for all levels
+static int rowCount(PickerState *state)
+{
+    return (state->count + GRID_COLUMNS - 1) / GRID_COLUMNS;
+}
+
+// Scroll grid so that selected level is visible
+static void showSelected(PickerState *state)
+{
+    int row = state->selected / GRID_COLUMNS;
+    if (row < state->top)
+        state->top = row;
+    if (row >= state->top + GRID_ROWS)
+        state->top = row - GRID_ROWS + 1;
+}
+
+// Move highlight by given number of levels, stops at first and last level
+// Returns true if rerender is needed
+static bool moveSelection(PickerState *state, int offset)
+{
+    int selected = state->selected + offset;
+    if (selected < 0)
+        selected = 0;
+    if (selected >= state->count)
+        selected = state->count - 1;
+    if (selected == state->selected)
+        return false;
+    state->selected = selected;
+    showSelected(state);
+    return true;
+}
+
+// Scroll grid by given number of rows, highlight stays on a visible level
+// Returns true if rerender is needed
+static bool scrollRows(PickerState *state, int rows)
+{
+    int top = state->top + rows;
+    if (top > rowCount(state) - GRID_ROWS)
+        top = rowCount(state) - GRID_ROWS;
+    if (top < 0)
+        top = 0;
+    if (top == state->top)
+        return false;
+    state->top = top;
+    int row = state->selected / GRID_COLUMNS;
+    if (row < top)
+        state->selected += (top - row) * GRID_COLUMNS;
+    if (row >= top + GRID_ROWS)
+        state->selected -= (row - top - GRID_ROWS + 1) * GRID_COLUMNS;
+    if (state->selected >= state->count)
+        state->selected = state->count - 1;
+    return true;
+}
+
+// Handle SDL key down event
+// Returns true if rerender is needed
+static bool handleKeydown(PickerState *state, SDL_Scancode key)
+{
+    switch (key)
+    {
+    case 0x50: // left arrow
+    case 0x04: // letter A
+        return moveSelection(state, -1);
+    case 0x52: // up arrow
+    case 0x1A: // letter W
+        return moveSelection(state, -GRID_COLUMNS);
+    case 0x4F: // right arrow
+    case 0x07: // letter D
+        return moveSelection(state, 1);
+    case 0x51: // down arrow
+    case 0x16: // letter S
+        return moveSelection(state, GRID_COLUMNS);
+    case 0x4b: // page up
+        return moveSelection(state, -GRID_COLUMNS * GRID_ROWS);
+    case 0x4e: // page down
+        return moveSelection(state, GRID_COLUMNS * GRID_ROWS);
+    case 0x28: // enter
+    case 0x2c: // spacebar
+        state->result = 1;
+        return false;
+    case 0x29: // esc
+    case 0x2b: // tab
+        state->result = 2;
+        return false;
+    default:
+        return false;
+    }
+}
+
+// Handle SDL mouse click
+// Clicking a level picks it
+// Returns true if rerender is needed
+static bool handleClick(PickerState *state, int x, int y)
+{
+    if (clickTile(0, 0, x, y)) // back without picking
+    {
+        state->result = 2;
+        return false;
+    }
+    if (clickTile(19, 0, x, y))
+        return scrollRows(state, -GRID_ROWS);
+    if (clickTile(19, 9, x, y))
+        return scrollRows(state, GRID_ROWS);
+    if (!clickTiles(1, 0, GRID_COLUMNS * 3, GRID_ROWS * 2 - 1, x, y))
+        return false;
+    int index = (state->top + y / 128) * GRID_COLUMNS + (x / 64 - 1) / 3;
+    if (index >= state->count)
+        return false;
+    state->selected = index;
+    state->result = 1;
+    return false;
+}
+
+// Handles SDL event
+// Returns true if rerender is needed
+static bool handleEvent(SDL_Event event, PickerState *state)
+{
+    switch (event.type)
+    {
+    case SDL_KEYDOWN:
+        return handleKeydown(state, event.key.keysym.scancode);
+    case SDL_MOUSEBUTTONDOWN:
+        return handleClick(state, event.button.x, event.button.y);
+    case SDL_MOUSEWHEEL:
+        return scrollRows(state, -event.wheel.y);
+    case SDL_QUIT: // exit program
+        state->result = 0;
+        return false;
+    default:
+        if (state->thumbnails == NULL || event.type != state->thumbnails->event)
+            return false;
+        uploadReady(state->thumbnails); // thumbnail arrived from worker
+        return true;
+    }
+}
+
+// Show thumbnails of all levels in a scrollable grid and let user pick one
+// Thumbnails: cache of previews, can be NULL, then only names are shown
+// Picked: current level on call, chosen level on return
+// Returns 0 on SDL_Quit, 1 if a level was picked, 2 if picking was cancelled
+int pickLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, Thumbnails *thumbnails, Level *first, Level **picked)
+{
+    PickerState state;
+    state.count = 0;
+    for (Level *level = first; level != NULL; level = level->next)
+        state.count++;
+    if (state.count == 0)
+        return 2;
+    state.levels = (Level **)malloc(sizeof(Level *) * state.count);
+    if (state.levels == NULL)
+        return alertBox(renderer, tiles, font, "Memóriafoglalási hiba") == 0 ? 0 : 2;
+    state.selected = 0;
+    int i = 0;
+    for (Level *level = first; level != NULL; level = level->next)
+    {
+        if (level == *picked)
+            state.selected = i;
+        state.levels[i++] = level;
+    }
+    state.top = 0;
+    state.result = -1;
+    state.thumbnails = thumbnails;
+    state.renderer = renderer;
+    state.tiles = tiles;
+    state.font = font;
+    showSelected(&state);
+
+    renderPicker(&state);
+
+    SDL_Event ev;
+    while (state.result == -1 && SDL_WaitEvent(&ev))
+    {
+        if (handleEvent(ev, &state))
+            renderPicker(&state);
+    }
+
+    if (thumbnails != NULL) // worker must not use levels after picker is closed
+        waitIdle(thumbnails);
+    if (state.result == 1)
+        *picked = state.levels[state.selected];
+    free(state.levels);
+    return state.result == -1 ? 0 : state.result;
+}
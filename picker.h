@@ -0,0 +1,17 @@
+#ifndef PICKER_H
+#define PICKER_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include "file.h"
+
+typedef struct Thumbnails Thumbnails;
+
+Thumbnails *startThumbnails(SDL_Renderer *renderer);
+void clearThumbnails(Thumbnails *thumbnails);
+void stopThumbnails(Thumbnails *thumbnails);
+
+int pickLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, Thumbnails *thumbnails, Level *first, Level **picked);
+
+#endif
@@ -3,6 +3,16 @@
 #include "input.h"
 #include "coordinates.h"
 #include "tiles.h"
+#include "stats.h"
+#include "path.h"
+#include "move.h"
+#include "replay.h"
+#include "game.h"
+#include "progress.h"
+#include "check.h"
+#include "preload.h"
+#include "picker.h"
+#include "levelindex.h"
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -13,18 +23,52 @@
 #include "debugmalloc.h"
 #endif
 
+// Coordinate offsets for each direction
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+#define TICK_MS 5     // fixed logic timestep of animations
+#define MOVE_TICKS 12 // length of a move animation in ticks
+#define FRAME_MS 16   // time between frames while something is animated
+
+// Sliding of player and pushed crate from their previous tiles
+// Game state changes immediately, only drawn positions lag behind
+typedef struct Animation
+{
+    bool active;
+    int tick;           // logic ticks done, animation ends at MOVE_TICKS
+    Uint32 accumulator; // ms not yet consumed by ticks, gives position between two ticks
+    Uint32 lastTime;    // SDL_GetTicks time of last advance
+    float playerX;      // drawn position of player at start of animation, in tiles
+    float playerY;
+    Coordinates crate; // tile the pushed crate moves to, x is -1 if no crate moves
+    float crateX;      // drawn position of crate at start of animation, in tiles
+    float crateY;
+} Animation;
+
 typedef struct PlayState
 {
     Level *firstLevel;
-    Level *level;
-    Level *backupLevel;
-    Coordinates player;
+    Game game;            // current level being played, moves since level was loaded or restarted
+    Coordinates selected; // selected crate for pushing, x is -1 if there is no selection
+    Animation animation;
+    MoveList best;        // shortest stored solution of level, empty if level was not solved yet
+    int savedMoves;       // number of moves stored in progress file, -1 if stored progress must be restarted
     int result;
     bool ctrl;
     bool edited;
     bool finished;
     bool unsaved;
+    SDL_Scancode heldKey;   // movement key repeated by the play loop, 0 if none is held
+    Uint32 nextRepeat;      // SDL_GetTicks time of next repeated move
+    int repeatDelay;        // ms from key press to first repeated move
+    int repeatInterval;     // ms between repeated moves
+    Thumbnails *thumbnails; // previews of level picker, started when picker is first opened
+    LevelIndex index;       // search index of levels, built when collection is loaded
+    char query[64];         // last search, offered again to find the next match
     char *filename;
+    char progressFile[70];
     SDL_Renderer *renderer;
     SDL_Texture *tiles;
     TTF_Font *font;
@@ -66,27 +110,11 @@ static TileState getTileState(Level *level, int x, int y)
     return level->tiles[x + y * level->size.x];
 }
 
-// Set state of tile at coordinates
-// Does nothing for tiles outside of play area
-static void setTileState(Level *level, int x, int y, TileState state)
+// Render a frame of play to renderer
+// Motion: drawn positions of player and moving crate, selected: selected crate, x is -1 if there is none
+// Finished: level is shown in win state
+void renderPlay(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, Level *level, Motion *motion, Coordinates selected, bool finished)
 {
-    if (x < 0 || y < 0 || x >= level->size.x || y >= level->size.y)
-    {
-        return;
-    }
-    level->tiles[x + y * level->size.x] = state;
-}
-
-// Render current state of play to renderer
-// State must include proper renderer, tiles, and font
-static void render(PlayState *state)
-{
-    // easier to work with variables this way
-    SDL_Renderer *renderer = state->renderer;
-    SDL_Texture *tiles = state->tiles;
-    TTF_Font *font = state->font;
-    Level *level = state->level;
-
     SDL_RenderClear(renderer);
 
     SDL_Color white = {255, 255, 255, 255};
@@ -95,26 +123,39 @@ static void render(PlayState *state)
     int startX = 1 + (19 - level->size.x) / 2;
     int startY = 0 + (11 - level->size.y) / 2;
 
-    renderTiles(renderer, tiles, state->finished ? greenFloor : greyFloor, 0, 0, 19, 11);                             // background for entire window, based on level finishedness
+    renderTiles(renderer, tiles, finished ? greenFloor : greyFloor, 0, 0, 19, 11);                                    // background for entire window, based on level finishedness
     renderTiles(renderer, tiles, brownFloor, startX, startY, startX + level->size.x - 1, startY + level->size.y - 1); // background for level area
 
     for (int i = 0; i < level->size.x; i++) // render tiles except floors
     {
         for (int j = 0; j < level->size.y; j++)
         {
-            Tile tile = tileStateToTile(level->tiles[i + j * level->size.x]);
+            TileState tileState = level->tiles[i + j * level->size.x];
+            if (i == motion->crate.x && j == motion->crate.y) // moving crate is drawn later, only what is under it here
+                tileState = tileState == crateOnTargetS ? targetS : floorTileS;
+            Tile tile = tileStateToTile(tileState);
             if (tile != brownFloor)
                 renderTile(renderer, tiles, tile, startX + i, startY + j);
         }
     }
 
-    // render player
-    renderTile(renderer, tiles, player, state->player.x + startX, state->player.y + startY);
+    // render moving crate and player
+    if (motion->crate.x != -1)
+    {
+        TileState crateState = level->tiles[motion->crate.x + motion->crate.y * level->size.x];
+        renderTileAt(renderer, tiles, tileStateToTile(crateState), (int)((motion->crateX + startX) * 64), (int)((motion->crateY + startY) * 64));
+    }
+    renderTileAt(renderer, tiles, player, (int)((motion->playerX + startX) * 64), (int)((motion->playerY + startY) * 64));
+
+    // render selected crate
+    if (selected.x != -1)
+        renderTile(renderer, tiles, selection, selected.x + startX, selected.y + startY);
 
     // control buttons
     renderTile(renderer, tiles, home, 0, 0);
     renderTile(renderer, tiles, retry, 0, 1);
     renderTile(renderer, tiles, save, 0, 2);
+    renderTile(renderer, tiles, levels, 0, 3);
 
     // player control buttons
     renderTile(renderer, tiles, up, 0, 6);
@@ -122,108 +163,162 @@ static void render(PlayState *state)
     renderTile(renderer, tiles, right, 0, 8);
     renderTile(renderer, tiles, down, 0, 9);
 
-    if (state->level->prev != NULL) // prevoius button is previous level exists
+    if (level->prev != NULL) // prevoius button is previous level exists
         renderTile(renderer, tiles, left, 0, 11);
     renderFont(renderer, font, white, level->name, 10, 11, true, true); // level name
-    if (state->level->next != NULL)                                     // next button in next level exists
+    if (level->next != NULL)                                            // next button in next level exists
         renderTile(renderer, tiles, right, 19, 11);
 
-    SDL_RenderPresent(renderer); // render creation
+    presentFrame(renderer); // render creation
 }
 
-// Check if all targets are covered by crates
-// Returns true if ^ true
-static bool checkFinished(PlayState *state)
+// Get drawn positions of player and moving crate at the current point of animation
+static void getMotion(PlayState *state, Motion *motion)
+{
+    Animation *animation = &state->animation;
+    motion->playerX = (float)state->game.player.x;
+    motion->playerY = (float)state->game.player.y;
+    motion->crate.x = -1;
+    motion->crate.y = -1;
+    if (!animation->active)
+        return;
+
+    float progress = (animation->tick + (float)animation->accumulator / TICK_MS) / MOVE_TICKS; // between ticks too
+    if (progress > 1)
+        progress = 1;
+    motion->playerX = animation->playerX + (state->game.player.x - animation->playerX) * progress;
+    motion->playerY = animation->playerY + (state->game.player.y - animation->playerY) * progress;
+    if (animation->crate.x != -1)
+    {
+        motion->crate = animation->crate;
+        motion->crateX = animation->crateX + (animation->crate.x - animation->crateX) * progress;
+        motion->crateY = animation->crateY + (animation->crate.y - animation->crateY) * progress;
+    }
+}
+
+// Start sliding player from where it was drawn before the move to its new tile
+// A move made during an animation continues from where the previous one is drawn, nothing is skipped
+// Motion: drawn positions before the move, pushed: player pushed a crate from its current tile in direction
+static void startAnimation(PlayState *state, Motion *motion, int dir, bool pushed)
 {
-    for (int i = 0; i < state->level->size.x * state->level->size.y; i++)
+    Animation *animation = &state->animation;
+    Coordinates player = state->game.player;
+    animation->playerX = motion->playerX;
+    animation->playerY = motion->playerY;
+    animation->crate.x = -1;
+    animation->crate.y = -1;
+    if (pushed)
     {
-        TileState tile = state->level->tiles[i];
-        if (tile == targetS)
+        animation->crate.x = player.x + dirX[dir]; // crate is in front of player
+        animation->crate.y = player.y + dirY[dir];
+        animation->crateX = (float)player.x; // crate was on the tile player stepped on
+        animation->crateY = (float)player.y;
+        if (motion->crate.x == player.x && motion->crate.y == player.y) // same crate was still sliding there
         {
-            return false;
+            animation->crateX = motion->crateX;
+            animation->crateY = motion->crateY;
         }
     }
-    return true;
+    animation->active = true;
+    animation->tick = 0;
+    animation->accumulator = 0;
+    animation->lastTime = SDL_GetTicks();
 }
 
-// Fill current game state with level data
-// This is for resetting a level
-static bool fillState(PlayState *state, Level *level)
+// Advance animation by the fixed logic timesteps that passed since last call
+// Returns true if a frame must be rendered
+static bool advanceAnimation(PlayState *state)
 {
-    if (state->level != NULL) // free level if one is loaded
+    Animation *animation = &state->animation;
+    if (!animation->active)
+        return false;
+    Uint32 now = SDL_GetTicks();
+    animation->accumulator += now - animation->lastTime;
+    animation->lastTime = now;
+    while (animation->accumulator >= TICK_MS && animation->tick < MOVE_TICKS)
     {
-        free(state->level->tiles);
-        free(state->level);
+        animation->tick++;
+        animation->accumulator -= TICK_MS;
     }
+    if (animation->tick >= MOVE_TICKS) // arrived, last frame shows tiles in place
+        animation->active = false;
+    return true;
+}
 
-    state->level = (Level *)malloc(sizeof(Level)); // allocate memory for each component that could change
-    if (state->level == NULL)
-        return false;
-    memcpy(state->level, level, sizeof(Level)); // copy data
+// Render current state of play to renderer
+// State must include proper renderer, tiles, and font
+static void render(PlayState *state)
+{
+    Motion motion;
+    getMotion(state, &motion);
+    renderPlay(state->renderer, state->tiles, state->font, state->game.level, &motion, state->selected, state->finished);
+}
 
-    state->level->tiles = (TileState *)malloc(sizeof(TileState) * (level->size.x * level->size.y));
-    if (state->level->tiles == NULL)
-        return false;
-    memcpy(state->level->tiles, level->tiles, sizeof(TileState) * (level->size.x * level->size.y));
+// Check if all targets are covered by crates
+// Returns true if ^ true
+static bool checkFinished(PlayState *state)
+{
+    return gameFinished(&state->game);
+}
 
-    state->backupLevel = level; // store original level pointer
+// Fill current game state with level data
+// Restore: continue stored progress of level, false is for resetting a level
+static bool fillState(PlayState *state, Level *level, bool restore)
+{
+    if (!startGame(&state->game, level))
+        return false;
 
-    for (int i = 0; i < level->size.x; i++) // extract player position and change tile under player
+    state->savedMoves = -1;
+    MoveList stored;
+    initMoves(&stored);
+    if (restore && loadProgress(state->progressFile, level, &stored, &state->best))
     {
-        for (int j = 0; j < level->size.y; j++)
+        ReplayResult replay = {0, 0, 0, false};
+        if (stored.moves != NULL)
+            replay = playMoves(&state->game, stored.moves);
+        if (replay.result == 0)
+            state->savedMoves = state->game.moves.length;
+        else if (!startGame(&state->game, level)) // stored progress does not match level, start from original level
         {
-            TileState tile = getTileState(level, i, j);
-            if (tile == playerS || tile == playerOnTargetS)
-            {
-                state->player.x = i;
-                state->player.y = j;
-                setTileState(state->level, i, j, tile == playerS ? floorTileS : targetS);
-            }
+            freeMoves(&stored);
+            return false;
         }
     }
-
+    freeMoves(&stored);
     state->edited = false;
+    state->animation.active = false;
+    state->selected.x = -1; // no crate is selected
+    state->selected.y = -1;
     state->finished = checkFinished(state); // chack is level has alerady been finished
 
     return true;
 }
 
-// Copy level data from state to level pointer
-// Does not modify data in current state, only overwrites level pointer data
-static void writeState(PlayState *state)
+// Append moves made since last save to progress file
+// Level file is never modified, only moves are stored
+// Returns true on success
+static bool storeProgress(PlayState *state)
 {
-    if (state->backupLevel == NULL) // cant save to no level
-        return;
+    bool restart = state->savedMoves == -1 || state->savedMoves > state->game.moves.length; // stored moves are no longer the start of current moves
+    char *moves = "";
+    if (state->game.moves.moves != NULL)
+        moves = state->game.moves.moves + (restart ? 0 : state->savedMoves);
 
-    memcpy(state->backupLevel->tiles, state->level->tiles, sizeof(TileState) * (state->level->size.x * state->level->size.y)); // copy data
-    TileState *currentPlayerPos = state->backupLevel->tiles + state->player.x + state->player.y * state->backupLevel->size.x;  // transfer player position too
-    if (*currentPlayerPos == targetS)
-        *currentPlayerPos = playerOnTargetS;
-    else
-        *currentPlayerPos = playerS;
+    if (!appendProgress(state->progressFile, state->game.start, moves, restart))
+        return false;
+    state->savedMoves = state->game.moves.length;
     state->edited = false;
+    state->unsaved = false;
+    return true;
 }
 
-// Save current levels to file
+// Save progress of current level
 // Warns user in case of saving error
 // Sets sate->result according to user popup state
 static void saveState(PlayState *state)
 {
-    writeState(state);
-    state->edited = false;
-    int result = textInput(state->renderer, state->tiles, state->font, "File neve", state->filename, 63);
-    if (result == 0)
-    {
-        state->result = 0;
-        return;
-    }
-    if (result == 2)
-        return;
-
-    bool saveSuccess = saveLevel(state->firstLevel, state->filename);
-    if (saveSuccess)
+    if (storeProgress(state))
     {
-        state->unsaved = false;
         if (alertBox(state->renderer, state->tiles, state->font, "Sikeres mentés!") == 0)
             state->result = 0;
     }
@@ -235,11 +330,10 @@ static void saveState(PlayState *state)
 // Does not set level pointer to null (even though it should)
 static void freeState(PlayState *state)
 {
-    if (state->level != NULL)
-    {
-        free(state->level->tiles);
-        free(state->level);
-    }
+    freeGame(&state->game);
+    freeMoves(&state->best);
+    stopThumbnails(state->thumbnails);
+    freeIndex(&state->index);
 }
 
 // Prompt player to save data or discard
@@ -252,8 +346,14 @@ static bool promptEdit(PlayState *state)
         state->result = 0;
         return false;
     }
-    if (result == 1)
-        writeState(state);
+    if (result == 1 && !storeProgress(state))
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, "Sikertelen mentés") == 0)
+        {
+            state->result = 0;
+            return false;
+        }
+    }
     return true;
 }
 
@@ -266,10 +366,10 @@ static void nextLevel(PlayState *state)
         if (!promptEdit(state))
             return;
     }
-    if (state->level->next != NULL)
+    if (state->game.level->next != NULL)
     {
-        Level *nextLevel = state->level->next;
-        fillState(state, nextLevel);
+        Level *nextLevel = state->game.level->next;
+        fillState(state, nextLevel, true);
     }
 }
 
@@ -282,40 +382,73 @@ static void prevLevel(PlayState *state)
         if (!promptEdit(state))
             return;
     }
-    if (state->level->prev != NULL)
+    if (state->game.level->prev != NULL)
     {
-        Level *prevLevel = state->level->prev;
-        fillState(state, prevLevel);
+        Level *prevLevel = state->game.level->prev;
+        fillState(state, prevLevel, true);
     }
 }
 
+// Show level picker and load chosen level to state
+// Prompts player if works should be stored
+static void pickCurrent(PlayState *state)
+{
+    if (state->thumbnails == NULL) // levels are not modified while playing, so thumbnails stay valid
+        state->thumbnails = startThumbnails(state->renderer);
+    Level *picked = state->game.start;
+    int result = pickLevel(state->renderer, state->tiles, state->font, state->thumbnails, state->firstLevel, &picked);
+    if (result == 0)
+    {
+        state->result = 0;
+        return;
+    }
+    if (result != 1 || picked == state->game.start)
+        return;
+    if (state->edited && !state->finished)
+    {
+        if (!promptEdit(state))
+            return;
+    }
+    fillState(state, picked, true);
+}
+
+// Ask player for search query and load next level matching it
+// Prompts player if works should be stored
+static void searchLevel(PlayState *state)
+{
+    int result = textInput(state->renderer, state->tiles, state->font, "Keresés (név, láda>8)", state->query, 63);
+    if (result != 1)
+    {
+        if (result == 0)
+            state->result = 0;
+        return;
+    }
+    int found = searchIndex(&state->index, state->query, findEntry(&state->index, state->game.start));
+    if (found < 0)
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, found == -1 ? "Nincs találat" : "Hibás keresés") == 0)
+            state->result = 0;
+        return;
+    }
+    Level *level = state->index.entries[found].level;
+    if (level == state->game.start)
+        return;
+    if (state->edited && !state->finished)
+    {
+        if (!promptEdit(state))
+            return;
+    }
+    fillState(state, level, true);
+}
+
 // Check validity of levels
 // Checks number of players and crate count and target count relation
 // Returns true if all levels are valid
 static bool checkLevels(Level *level)
 {
-
     while (level != NULL)
     {
-        int playerCount = 0;
-        int crateCount = 0;
-        int targetCount = 0;
-        for (int i = 0; i < level->size.x * level->size.y; i++)
-        {
-            if (level->tiles[i] == playerS || level->tiles[i] == playerOnTargetS)
-            {
-                playerCount++;
-            }
-            if (level->tiles[i] == crateS || level->tiles[i] == crateOnTargetS)
-            {
-                crateCount++;
-            }
-            if (level->tiles[i] == targetS || level->tiles[i] == crateOnTargetS || level->tiles[i] == playerOnTargetS)
-            {
-                targetCount++;
-            }
-        }
-        if (playerCount != 1 || crateCount < targetCount)
+        if (!validLevel(level))
         {
             return false;
         }
@@ -334,169 +467,148 @@ static void checkWinState(PlayState *state)
     if (checkFinished(state))
     {
         state->finished = true;
-        writeState(state);
+        bool stored = storeProgress(state);
+        if (stored && (state->best.length == 0 || state->game.moves.length < state->best.length)) // new best solution
+        {
+            stored = appendSolution(state->progressFile, state->game.start, state->game.moves.moves);
+            clearMoves(&state->best);
+            for (int i = 0; i < state->game.moves.length && stored; i++)
+            {
+                bool push;
+                int dir = charToMove(state->game.moves.moves[i], &push);
+                stored = appendMove(&state->best, dir, push);
+            }
+        }
+        if (!stored && alertBox(state->renderer, state->tiles, state->font, "Sikertelen mentés") == 0)
+            state->result = 0;
         if (alertBox(state->renderer, state->tiles, state->font, "Sikeresen tejesítetted a pályát!") == 0)
             state->result = 0;
     }
 }
 
-// Move player left
+// Process player movement
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
 // Returns true if rerender is needed
-static bool moveLeft(PlayState *state)
+static bool processMovement(int dir, PlayState *state)
 {
-    Coordinates *player = &state->player;
-    if (getTileState(state->level, player->x - 1, player->y) == crateS ||
-        getTileState(state->level, player->x - 1, player->y) == crateOnTargetS) // crate in front of player
-    {
-        if (getTileState(state->level, player->x - 2, player->y) == floorTileS ||
-            getTileState(state->level, player->x - 2, player->y) == targetS) // crate can move
-        {
-            if (getTileState(state->level, player->x - 1, player->y) == crateS)   // crate not on target
-                setTileState(state->level, player->x - 1, player->y, floorTileS); // replace crate with floor
-            else
-                setTileState(state->level, player->x - 1, player->y, targetS);      // replace player with target
-            if (getTileState(state->level, player->x - 2, player->y) == floorTileS) // crate going to be on floor
-                setTileState(state->level, player->x - 2, player->y, crateS);       // replace with crate
-            else
-                setTileState(state->level, player->x - 2, player->y, crateOnTargetS); // replace with crate on target
-            player->x--;                                                              // move player
-            checkWinState(state);
-            return true;
-        }
+    state->edited = true;
+    state->unsaved = true;
+    state->selected.x = -1; // selected crate might move
+    state->selected.y = -1;
+
+    Motion before;
+    getMotion(state, &before);
+    MoveResult result = gameMove(&state->game, dir); // move history is lost on memory allocation failure
+    if (result == blockedM)
         return false;
-    }
-    if (getTileState(state->level, player->x - 1, player->y) == floorTileS ||
-        getTileState(state->level, player->x - 1, player->y) == targetS) // player can move
-    {
-        player->x--; // move player
-        return true;
-    }
-    return false;
+    startAnimation(state, &before, dir, result == pushedM);
+    if (result == pushedM)
+        checkWinState(state);
+    return true;
 }
 
-// Move player up
+// Take back last move of player
 // Returns true if rerender is needed
-static bool moveUp(PlayState *state)
+static bool undoLastMove(PlayState *state)
 {
-    Coordinates *player = &state->player;
-    if (getTileState(state->level, player->x, player->y - 1) == crateS ||
-        getTileState(state->level, player->x, player->y - 1) == crateOnTargetS) // crate in front of player
-    {
-        if (getTileState(state->level, player->x, player->y - 2) == floorTileS ||
-            getTileState(state->level, player->x, player->y - 2) == targetS) // crate can move
-        {
-            if (getTileState(state->level, player->x, player->y - 1) == crateS)   // crate not on target
-                setTileState(state->level, player->x, player->y - 1, floorTileS); // replace crate with floor
-            else
-                setTileState(state->level, player->x, player->y - 1, targetS);      // replace player with target
-            if (getTileState(state->level, player->x, player->y - 2) == floorTileS) // crate going to be on floor
-                setTileState(state->level, player->x, player->y - 2, crateS);       // replace with crate
-            else
-                setTileState(state->level, player->x, player->y - 2, crateOnTargetS); // replace with crate on target
-            player->y--;                                                              // move player
-            checkWinState(state);
-            return true;
-        }
+    if (!undoMove(&state->game))
         return false;
-    }
-    if (getTileState(state->level, player->x, player->y - 1) == floorTileS ||
-        getTileState(state->level, player->x, player->y - 1) == targetS) // player can move
+    state->animation.active = false; // taken back moves are not animated
+    if (state->savedMoves > state->game.moves.length) // stored progress contains taken back moves, it must be restarted
+        state->savedMoves = -1;
+    state->finished = checkFinished(state); // winning push might have been taken back
+    state->edited = true;
+    state->unsaved = true;
+    state->selected.x = -1; // selected crate might move
+    state->selected.y = -1;
+    return true;
+}
+
+// Apply moves found by path finding to current state
+// Stops if level gets finished or program exit was requested
+// Moves of a path are not animated, every move would start sliding from the tile where the path started
+static void applyMoves(PlayState *state, int *moves, int length)
+{
+    bool finished = state->finished;
+    for (int i = 0; i < length && state->result == -1; i++)
     {
-        player->y--; // move player
-        return true;
+        processMovement(moves[i], state);
+        if (state->finished && !finished) // level was finished during path
+            break;
     }
-    return false;
+    state->animation.active = false;
 }
 
-// Move player right
+// Walk player to given tile of level along the shortest path, without pushing crates
+// All moves are applied in one batch, so only one rerender is needed
 // Returns true if rerender is needed
-static bool moveRight(PlayState *state)
+static bool walkTo(PlayState *state, int x, int y)
 {
-    Coordinates *player = &state->player;
-    if (getTileState(state->level, player->x + 1, player->y) == crateS ||
-        getTileState(state->level, player->x + 1, player->y) == crateOnTargetS) // crate in front of player
-    {
-        if (getTileState(state->level, player->x + 2, player->y) == floorTileS ||
-            getTileState(state->level, player->x + 2, player->y) == targetS) // crate can move
-        {
-            if (getTileState(state->level, player->x + 1, player->y) == crateS)   // crate not on target
-                setTileState(state->level, player->x + 1, player->y, floorTileS); // replace crate with floor
-            else
-                setTileState(state->level, player->x + 1, player->y, targetS);      // replace player with target
-            if (getTileState(state->level, player->x + 2, player->y) == floorTileS) // crate going to be on floor
-                setTileState(state->level, player->x + 2, player->y, crateS);       // replace with crate
-            else
-                setTileState(state->level, player->x + 2, player->y, crateOnTargetS); // replace with crate on target
-            player->x++;                                                              // move player
-            checkWinState(state);
-            return true;
-        }
-        return false;
-    }
-    if (getTileState(state->level, player->x + 1, player->y) == floorTileS ||
-        getTileState(state->level, player->x + 1, player->y) == targetS) // player can move
+    Level *level = state->game.level;
+    Coordinates target = {x, y};
+    int maxMoves = level->size.x * level->size.y;
+    int *moves = (int *)malloc(sizeof(int) * maxMoves);
+    if (moves == NULL)
     {
-        player->x++; // move player
+        if (alertBox(state->renderer, state->tiles, state->font, "Memóriafoglalási hiba") == 0)
+            state->result = 0;
         return true;
     }
-    return false;
+
+    int length = findPath(level, state->game.player, target, moves, maxMoves);
+    applyMoves(state, moves, length); // path contains no pushes
+
+    free(moves);
+    if (length == -2 && alertBox(state->renderer, state->tiles, state->font, "Memóriafoglalási hiba") == 0)
+        state->result = 0;
+    return length != -1;
 }
 
-// Move player down
+// Push selected crate to given tile of level with the least possible pushes
+// Player walks between pushes automatically, all moves are applied in one batch
 // Returns true if rerender is needed
-static bool moveDown(PlayState *state)
+static bool pushTo(PlayState *state, int x, int y)
 {
-    Coordinates *player = &state->player;
-    if (getTileState(state->level, player->x, player->y + 1) == crateS ||
-        getTileState(state->level, player->x, player->y + 1) == crateOnTargetS) // crate in front of player
-    {
-        if (getTileState(state->level, player->x, player->y + 2) == floorTileS ||
-            getTileState(state->level, player->x, player->y + 2) == targetS) // crate can move
-        {
-            if (getTileState(state->level, player->x, player->y + 1) == crateS)   // crate not on target
-                setTileState(state->level, player->x, player->y + 1, floorTileS); // replace crate with floor
-            else
-                setTileState(state->level, player->x, player->y + 1, targetS);      // replace player with target
-            if (getTileState(state->level, player->x, player->y + 2) == floorTileS) // crate going to be on floor
-                setTileState(state->level, player->x, player->y + 2, crateS);       // replace with crate
-            else
-                setTileState(state->level, player->x, player->y + 2, crateOnTargetS); // replace with crate on target
-            player->y++;                                                              // move player
-            checkWinState(state);
-            return true;
-        }
-        return false;
-    }
-    if (getTileState(state->level, player->x, player->y + 1) == floorTileS ||
-        getTileState(state->level, player->x, player->y + 1) == targetS) // player can move
+    Coordinates target = {x, y};
+    int *moves;
+    int length = findPushPath(state->game.level, state->game.player, state->selected, target, &moves);
+    state->selected.x = -1; // selection is consumed even if crate cannot be moved
+    state->selected.y = -1;
+    if (length == -2)
     {
-        player->y++; // move player
+        if (alertBox(state->renderer, state->tiles, state->font, "Memóriafoglalási hiba") == 0)
+            state->result = 0;
         return true;
     }
-    return false;
+    applyMoves(state, moves, length);
+    free(moves);
+    return true;
 }
 
-// Process player movement
-// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+// Handle click on tile of level
+// Crates are selected by clicking on them, next click pushes selected crate to clicked tile
+// Without selected crate player walks to clicked tile
 // Returns true if rerender is needed
-static bool processMovement(int dir, PlayState *state)
+static bool clickLevel(PlayState *state, int x, int y)
 {
-    state->edited = true;
-    state->unsaved = true;
-
-    switch (dir)
+    TileState tile = getTileState(state->game.level, x, y);
+    if (tile == crateS || tile == crateOnTargetS)
     {
-    case 0: // left
-        return moveLeft(state);
-    case 1: // up
-        return moveUp(state);
-    case 2: // right
-        return moveRight(state);
-    case 3: // down
-        return moveDown(state);
-    default:
-        return false;
+        if (state->selected.x == x && state->selected.y == y) // clicking on selected crate removes selection
+        {
+            state->selected.x = -1;
+            state->selected.y = -1;
+        }
+        else
+        {
+            state->selected.x = x;
+            state->selected.y = y;
+        }
+        return true;
     }
+    if (state->selected.x != -1)
+        return pushTo(state, x, y);
+    return walkTo(state, x, y);
 }
 
 // Handle exit to menu
@@ -522,10 +634,190 @@ static void handleExitToMenu(PlayState *state)
     }
 }
 
+// Suggest file name for LURD file of current level
+// Name must be able to hold 64 characters
+static void lurdName(PlayState *state, char *name)
+{
+    if (strlen(state->game.level->name) + 5 > 63) // name is too long for suffix
+        strcpy(name, "megoldas.lurd");
+    else
+        sprintf(name, "%s.lurd", state->game.level->name);
+}
+
+// Save moves made on current level as LURD string
+// Prompts player for file name and warns in case of saving error
+static void exportMoves(PlayState *state)
+{
+    char name[64];
+    lurdName(state, name);
+
+    int result = textInput(state->renderer, state->tiles, state->font, "Lépések mentése", name, 63);
+    if (result != 1)
+    {
+        if (result == 0)
+            state->result = 0;
+        return;
+    }
+
+    if (state->game.moves.moves == NULL || !saveLurd(state->game.moves.moves, name))
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, "Sikertelen mentés") == 0)
+            state->result = 0;
+    }
+    else if (alertBox(state->renderer, state->tiles, state->font, "Sikeres mentés!") == 0)
+        state->result = 0;
+}
+
+// Replay LURD moves on current level from its starting position
+// Renders after every move, any key press or click skips animation and applies remaining moves at once
+// Returns false if moves are invalid or do not match play rules
+static bool animateMoves(PlayState *state, char *lurd)
+{
+    fillState(state, state->game.start, false);
+    bool animate = true;
+
+    for (char *c = lurd; *c != '\0' && state->result == -1; c++)
+    {
+        bool push;
+        int dir = charToMove(*c, &push);
+        if (dir == -1)
+            return false;
+        int length = state->game.moves.length;
+        if (!processMovement(dir, state) || state->game.moves.length != length + 1 || state->game.moves.moves[length] != *c) // recorded move must match, including push
+            return false;
+        state->animation.active = false; // replay has its own pace
+
+        if (animate)
+        {
+            render(state);
+            SDL_Event ev;
+            if (SDL_WaitEventTimeout(&ev, 40))
+            {
+                if (ev.type == SDL_QUIT)
+                    state->result = 0;
+                if (ev.type == SDL_KEYDOWN || ev.type == SDL_MOUSEBUTTONDOWN)
+                    animate = false;
+            }
+        }
+    }
+    return true;
+}
+
+// Load LURD string from file and replay it on current level
+// Prompts player for file name and warns if file is invalid
+static void importMoves(PlayState *state)
+{
+    if (state->edited && !state->finished)
+    {
+        if (!promptEdit(state))
+            return;
+    }
+
+    char name[64];
+    lurdName(state, name);
+
+    int result = textInput(state->renderer, state->tiles, state->font, "Lépések betöltése", name, 63);
+    if (result != 1)
+    {
+        if (result == 0)
+            state->result = 0;
+        return;
+    }
+
+    char *lurd = loadLurd(name);
+    if (lurd == NULL)
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, "Nem lehet megnyitni a fájlt") == 0)
+            state->result = 0;
+        return;
+    }
+    if (!animateMoves(state, lurd) && state->result == -1)
+    {
+        if (alertBox(state->renderer, state->tiles, state->font, "Hibás lépéssor") == 0)
+            state->result = 0;
+    }
+    free(lurd);
+}
+
+// Get direction of movement key
+// Returns -1 if key does not move the player
+static int keyToDir(SDL_Scancode key)
+{
+    switch (key)
+    {
+    case 0x50: // left arrow
+    case 0x04: // letter A
+        return 0;
+    case 0x52: // up arrow
+    case 0x1A: // letter W
+        return 1;
+    case 0x4F: // right arrow
+    case 0x07: // letter D
+        return 2;
+    case 0x51: // down arrow
+    case 0x16: // letter S
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+// Read key repeat rates from SOKOBAN_REPEAT environment variable as "delay,interval" in ms
+// Keeps default rates if variable is not set or invalid
+static void loadRepeatRates(PlayState *state)
+{
+    state->repeatDelay = 180;
+    state->repeatInterval = 70;
+    char *rates = SDL_getenv("SOKOBAN_REPEAT");
+    int delay, interval;
+    if (rates != NULL && sscanf(rates, "%d,%d", &delay, &interval) == 2 && delay >= 0 && interval > 0)
+    {
+        state->repeatDelay = delay;
+        state->repeatInterval = interval;
+    }
+}
+
+// Move player again if a movement key is still held and its repeat time came
+// Repeats are never queued: if rendering fell behind, the next repeat is scheduled from now
+// Returns true if rerender is needed
+static bool repeatHeldKey(PlayState *state)
+{
+    if (state->heldKey == 0)
+        return false;
+    if (state->ctrl || !SDL_GetKeyboardState(NULL)[state->heldKey]) // released while a dialog was open
+    {
+        state->heldKey = 0;
+        return false;
+    }
+    Uint32 now = SDL_GetTicks();
+    if ((Sint32)(now - state->nextRepeat) < 0)
+        return false;
+    state->nextRepeat += state->repeatInterval;
+    if ((Sint32)(now - state->nextRepeat) >= 0)
+        state->nextRepeat = now + state->repeatInterval;
+    return processMovement(keyToDir(state->heldKey), state);
+}
+
+// Get time in ms the play loop may wait for events before the next repeated move
+// Returns -1 if no key is held
+static int repeatTimeout(PlayState *state)
+{
+    if (state->heldKey == 0)
+        return -1;
+    Sint32 wait = (Sint32)(state->nextRepeat - SDL_GetTicks());
+    return wait > 0 ? wait : 0;
+}
+
 // Handle SDL key down event
 // Returns true if erernder is needed
 static bool handleKeydown(PlayState *state, SDL_Scancode key)
 {
+    if (keyToDir(key) != -1 && !state->ctrl) // play loop repeats held movement keys itself
+    {
+        state->heldKey = key;
+        state->nextRepeat = SDL_GetTicks() + state->repeatDelay;
+    }
+
     switch (key)
     {
     case 0x50: // left arrow
@@ -555,8 +847,24 @@ static bool handleKeydown(PlayState *state, SDL_Scancode key)
     case 0x15: // letter r
         if (!state->ctrl)
             return false;
-        fillState(state, state->backupLevel);
+        fillState(state, state->game.start, false);
         return true;
+    case 0x08: // letter e
+        if (!state->ctrl)
+            return false;
+        exportMoves(state);
+        state->ctrl = false;
+        return true;
+    case 0x0f: // letter l
+        if (!state->ctrl)
+            return false;
+        importMoves(state);
+        state->ctrl = false;
+        return true;
+    case 0x1c: // letter z
+        if (!state->ctrl)
+            return false;
+        return undoLastMove(state);
     case 0x29: // esc
         if (state->ctrl)
             return false;
@@ -572,6 +880,17 @@ static bool handleKeydown(PlayState *state, SDL_Scancode key)
             return false;
         prevLevel(state);
         return true;
+    case 0x2b: // tab
+        if (state->ctrl)
+            return false;
+        pickCurrent(state);
+        return true;
+    case 0x09: // letter f
+        if (!state->ctrl)
+            return false;
+        searchLevel(state);
+        state->ctrl = false;
+        return true;
     case 0xe0: // left ctrl
     case 0xe4: // right ctrl
         state->ctrl = true;
@@ -586,6 +905,8 @@ static bool handleKeydown(PlayState *state, SDL_Scancode key)
 // Returns true if erernder is needed
 static bool handleKeyup(PlayState *state, SDL_Scancode key)
 {
+    if (key == state->heldKey)
+        state->heldKey = 0;
     switch (key)
     {
     case 0xe0: // left ctrl
@@ -616,7 +937,7 @@ static bool handleClick(PlayState *state, int x, int y)
     }
     if (clickTile(0, 1, x, y)) // restart level
     {
-        fillState(state, state->backupLevel);
+        fillState(state, state->game.start, false);
         return true;
     }
     if (clickTile(0, 2, x, y)) // save level
@@ -624,6 +945,11 @@ static bool handleClick(PlayState *state, int x, int y)
         saveState(state);
         return true;
     }
+    if (clickTile(0, 3, x, y)) // level picker
+    {
+        pickCurrent(state);
+        return true;
+    }
     if (clickTile(0, 11, x, y)) // previouse level
     {
         prevLevel(state);
@@ -634,6 +960,12 @@ static bool handleClick(PlayState *state, int x, int y)
         nextLevel(state);
         return true;
     }
+
+    // start positions of level, same as in render
+    int startX = 1 + (19 - state->game.level->size.x) / 2;
+    int startY = 0 + (11 - state->game.level->size.y) / 2;
+    if (clickTiles(startX, startY, startX + state->game.level->size.x - 1, startY + state->game.level->size.y - 1, x, y)) // tile of level
+        return clickLevel(state, x / 64 - startX, y / 64 - startY);
     return false;
 }
 
@@ -644,6 +976,8 @@ static bool handleEvent(SDL_Event event, PlayState *state)
     switch (event.type)
     {
     case SDL_KEYDOWN:
+        if (event.key.repeat) // held keys are repeated by the play loop
+            return false;
         return handleKeydown(state, event.key.keysym.scancode);
     case SDL_KEYUP:
         return handleKeyup(state, event.key.keysym.scancode);
@@ -662,7 +996,7 @@ static bool handleEvent(SDL_Event event, PlayState *state)
 // Returns 0 on SDL_Quit, 1 on exit to menu
 int playLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *filename)
 {
-    LoadLevelResult result = loadLevel(filename);
+    LoadLevelResult result = openLevels(filename); // collection may have been parsed during startup
     switch (result.result)
     {
     case 1:
@@ -708,11 +1042,18 @@ int playLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *
     }
 
     PlayState state;
-    state.level = NULL;
     state.firstLevel = result.level;
-    if (!fillState(&state, result.level))
+    state.thumbnails = NULL;
+    state.query[0] = '\0';
+    initGame(&state.game);
+    initMoves(&state.best);
+    state.filename = filename;
+    progressName(filename, state.progressFile);
+    bool indexed = buildIndex(&state.index, result.level); // index is kept while collection is open, levels are not modified
+    if (!indexed || !fillState(&state, result.level, true))
     {
         unloadLevel(result.level);
+        freeState(&state);
         return alertBox(renderer, tiles, font, "Memóriafoglalási hiba");
     }
     state.result = -1;
@@ -721,23 +1062,40 @@ int playLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *
     state.font = font;
     state.ctrl = false;
     state.unsaved = false;
-    state.filename = filename;
+    state.heldKey = 0;
+    loadRepeatRates(&state);
 
     render(&state);
 
     SDL_Event ev;
-    while (SDL_WaitEvent(&ev))
+    while (true)
     {
-        bool rerender = handleEvent(ev, &state);
+        int timeout = repeatTimeout(&state);
+        if (state.animation.active && (timeout == -1 || timeout > FRAME_MS)) // wake up for next frame
+            timeout = FRAME_MS;
+        bool received = timeout == -1 ? SDL_WaitEvent(&ev) : SDL_WaitEventTimeout(&ev, timeout);
+        if (!received && timeout == -1) // waiting failed
+            break;
+
+        // handle every pending event before rendering, so input never waits behind frames
+        bool rerender = received && handleEvent(ev, &state);
+        while (state.result == -1 && SDL_PollEvent(&ev))
+            rerender = handleEvent(ev, &state) || rerender;
+        if (state.result == -1)
+            rerender = repeatHeldKey(&state) || rerender;
+        rerender = advanceAnimation(&state) || rerender;
+
         if (state.result != -1) // if result was set
         {
             unloadLevel(result.level);
             freeState(&state);
             return state.result; // return to main
         }
-        if (rerender) // if rerender is needed
+        if (rerender) // if rerender is needed, once for all handled events and animation steps
             render(&state);
     }
 
+    unloadLevel(result.level);
+    freeState(&state);
     return 0;
 }
\ No newline at end of file
@@ -4,7 +4,20 @@
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_ttf.h>
+#include <stdbool.h>
+#include "file.h"
+#include "coordinates.h"
+
+typedef struct Motion
+{
+    float playerX; // drawn position of player in tiles, can be between tiles
+    float playerY;
+    Coordinates crate; // tile of crate drawn at crateX, crateY instead, x is -1 if there is none
+    float crateX;
+    float crateY;
+} Motion;
 
 int playLevel(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, char *filename);
+void renderPlay(SDL_Renderer *renderer, SDL_Texture *tiles, TTF_Font *font, Level *level, Motion *motion, Coordinates selected, bool finished);
 
 #endif
\ No newline at end of file
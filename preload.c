@@ -0,0 +1,108 @@
+#include "preload.h"
+#include "file.h"
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Collection parsed on a worker thread during startup
+// Only the main thread touches this, worker writes result before it exits
+static struct
+{
+    SDL_Thread *thread;
+    char filename[64];
+    LoadLevelResult result;
+} preload;
+
+// Get path of file storing last used collection
+// Returns false if there is no writable preferences directory
+static bool lastFilePath(char *path, int size)
+{
+    char *directory = SDL_GetPrefPath("nhf", "sokoban");
+    if (directory == NULL)
+        return false;
+    bool fits = snprintf(path, size, "%slast.txt", directory) < size;
+    SDL_free(directory);
+    return fits;
+}
+
+// Read name of collection opened last time
+// Filename must be able to hold size characters
+// Returns false if it is not known
+bool readLastFile(char *filename, int size)
+{
+    char path[1024];
+    if (!lastFilePath(path, sizeof(path)))
+        return false;
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+    bool success = fgets(filename, size, file) != NULL;
+    fclose(file);
+    if (success)
+        filename[strcspn(filename, "\r\n")] = '\0';
+    return success && filename[0] != '\0';
+}
+
+// Remember name of opened collection for next start
+// Failure is ignored, it only costs a slower next start
+void writeLastFile(char *filename)
+{
+    char path[1024];
+    if (!lastFilePath(path, sizeof(path)))
+        return;
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+        return;
+    fprintf(file, "%s\n", filename);
+    fclose(file);
+}
+
+// Parse preloaded collection
+static int preloadThread(void *data)
+{
+    (void)data;
+    preload.result = loadLevel(preload.filename);
+    return 0;
+}
+
+// Start parsing collection in the background
+// Only one collection can be preloaded, starting is skipped if one is already loading
+void startPreload(char *filename)
+{
+    if (preload.thread != NULL || strlen(filename) >= sizeof(preload.filename))
+        return;
+    strcpy(preload.filename, filename);
+    preload.thread = SDL_CreateThread(preloadThread, "preload", NULL);
+}
+
+// Load collection, using the preloaded one if it is the same file
+// Preloaded collection is used only for the first open, later opens read the file again as it may have been saved
+// Result: same as loadLevel
+LoadLevelResult openLevels(char *filename)
+{
+    if (preload.thread != NULL)
+    {
+        SDL_WaitThread(preload.thread, NULL);
+        preload.thread = NULL;
+        if (strcmp(filename, preload.filename) == 0)
+            return preload.result;
+        unloadLevel(preload.result.level); // other file was opened
+    }
+    return loadLevel(filename);
+}
+
+// Wait for preloading and free collection if it was not used
+void stopPreload(void)
+{
+    if (preload.thread == NULL)
+        return;
+    SDL_WaitThread(preload.thread, NULL);
+    preload.thread = NULL;
+    unloadLevel(preload.result.level);
+}
@@ -0,0 +1,13 @@
+#ifndef PRELOAD_H
+#define PRELOAD_H
+
+#include <stdbool.h>
+#include "file.h"
+
+bool readLastFile(char *filename, int size);
+void writeLastFile(char *filename);
+void startPreload(char *filename);
+LoadLevelResult openLevels(char *filename);
+void stopPreload(void);
+
+#endif
@@ -0,0 +1,162 @@
+#include "progress.h"
+#include "file.h"
+#include "replay.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Progress file is stored next to level file with .sav extension
+// Every line is a record of one level, identified by hash of the original level:
+// "R <hash>" - progress was restarted
+// "P <hash> <LURD>" - moves made since previous record, appended to progress
+// "S <hash> <LURD>" - complete solution of level
+
+// Hash size and tiles of level with 64 bit FNV-1a
+// Level name is not included, so renamed levels keep their progress
+unsigned long long hashLevel(Level *level)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    int values[2] = {level->size.x, level->size.y};
+    for (int i = 0; i < 2; i++)
+    {
+        hash ^= (unsigned long long)values[i];
+        hash *= 1099511628211ULL;
+    }
+    for (int i = 0; i < level->size.x * level->size.y; i++)
+    {
+        hash ^= (unsigned long long)level->tiles[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Get name of progress file for level file
+// progressFile must be able to hold 5 more characters than filename
+void progressName(char *filename, char *progressFile)
+{
+    strcpy(progressFile, filename);
+    strcat(progressFile, ".sav");
+}
+
+// Read moves of record until end of line
+// Returns false on memory allocation failure
+static bool readRecordMoves(FILE *file, MoveList *list)
+{
+    int c;
+    while ((c = fgetc(file)) != EOF && c != '\n')
+    {
+        bool push;
+        int dir = charToMove((char)c, &push);
+        if (dir != -1 && !appendMove(list, dir, push))
+            return false;
+    }
+    return true;
+}
+
+// Skip rest of current line
+static void skipLine(FILE *file)
+{
+    int c;
+    while ((c = fgetc(file)) != EOF && c != '\n')
+        ;
+}
+
+// Load stored progress and best solution of level from progress file
+// moves and best are cleared first, best stays empty if level has no stored solution
+// Missing progress file is not an error, level simply has no progress
+// Returns false on memory allocation failure
+bool loadProgress(char *progressFile, Level *level, MoveList *moves, MoveList *best)
+{
+    clearMoves(moves);
+    clearMoves(best);
+
+    FILE *file = fopen(progressFile, "r");
+    if (file == NULL)
+        return true;
+
+    unsigned long long hash = hashLevel(level);
+    MoveList solution;
+    initMoves(&solution);
+    bool success = true;
+    int type;
+
+    while (success && (type = fgetc(file)) != EOF)
+    {
+        unsigned long long recordHash;
+        if (fscanf(file, " %llx", &recordHash) != 1 || recordHash != hash) // record of other level or invalid record
+        {
+            if (type != '\n')
+                skipLine(file);
+            continue;
+        }
+        switch (type)
+        {
+        case 'R':
+            clearMoves(moves);
+            skipLine(file);
+            break;
+        case 'P':
+            success = readRecordMoves(file, moves);
+            break;
+        case 'S':
+            clearMoves(&solution);
+            success = readRecordMoves(file, &solution);
+            if (success && solution.length > 0 && (best->length == 0 || solution.length < best->length)) // keep shortest solution
+            {
+                MoveList swap = *best;
+                *best = solution;
+                solution = swap;
+            }
+            break;
+        default:
+            skipLine(file);
+            break;
+        }
+    }
+
+    freeMoves(&solution);
+    fclose(file);
+    return success;
+}
+
+// Append record to end of progress file
+// Returns true on success, false on failure
+static bool appendRecord(char *progressFile, char type, unsigned long long hash, char *moves)
+{
+    FILE *file = fopen(progressFile, "a");
+    if (file == NULL)
+        return false;
+
+    if (moves == NULL)
+        fprintf(file, "%c %016llx\n", type, hash);
+    else
+        fprintf(file, "%c %016llx %s\n", type, hash, moves);
+
+    return fclose(file) == 0;
+}
+
+// Append moves to stored progress of level
+// If restart is true, previously stored progress is discarded first
+// Returns true on success, false on failure
+bool appendProgress(char *progressFile, Level *level, char *moves, bool restart)
+{
+    unsigned long long hash = hashLevel(level);
+    if (restart && !appendRecord(progressFile, 'R', hash, NULL))
+        return false;
+    if (moves == NULL || *moves == '\0') // nothing to append
+        return true;
+    return appendRecord(progressFile, 'P', hash, moves);
+}
+
+// Append solution of level to progress file
+// Returns true on success, false on failure
+bool appendSolution(char *progressFile, Level *level, char *moves)
+{
+    return appendRecord(progressFile, 'S', hashLevel(level), moves);
+}
@@ -0,0 +1,14 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <stdbool.h>
+#include "file.h"
+#include "replay.h"
+
+unsigned long long hashLevel(Level *level);
+void progressName(char *filename, char *progressFile);
+bool loadProgress(char *progressFile, Level *level, MoveList *moves, MoveList *best);
+bool appendProgress(char *progressFile, Level *level, char *moves, bool restart);
+bool appendSolution(char *progressFile, Level *level, char *moves);
+
+#endif
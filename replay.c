@@ -0,0 +1,213 @@
+#include "replay.h"
+#include "move.h"
+#include "file.h"
+#include "coordinates.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Convert direction to LURD character
+// Lowercase for moves, uppercase for pushes, returns space on invalid direction
+char moveToChar(int dir, bool push)
+{
+    switch (dir)
+    {
+    case 0:
+        return push ? 'L' : 'l';
+    case 1:
+        return push ? 'U' : 'u';
+    case 2:
+        return push ? 'R' : 'r';
+    case 3:
+        return push ? 'D' : 'd';
+    default:
+        return ' ';
+    }
+}
+
+// Convert LURD character to direction
+// Push is set to true for uppercase characters
+// Returns direction on success, -1 on invalid character
+int charToMove(char c, bool *push)
+{
+    *push = c >= 'A' && c <= 'Z';
+    switch (c)
+    {
+    case 'l':
+    case 'L':
+        return 0;
+    case 'u':
+    case 'U':
+        return 1;
+    case 'r':
+    case 'R':
+        return 2;
+    case 'd':
+    case 'D':
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+// Initialize empty move list, no memory is allocated until first move
+void initMoves(MoveList *list)
+{
+    list->moves = NULL;
+    list->length = 0;
+    list->capacity = 0;
+}
+
+// Append move to end of list, list grows as needed
+// Returns false on memory allocation failure
+bool appendMove(MoveList *list, int dir, bool push)
+{
+    if (list->length + 1 >= list->capacity) // room for new move and terminating zero
+    {
+        int capacity = list->capacity == 0 ? 256 : list->capacity * 2;
+        char *moves = (char *)realloc(list->moves, capacity);
+        if (moves == NULL)
+            return false;
+        list->moves = moves;
+        list->capacity = capacity;
+    }
+    list->moves[list->length++] = moveToChar(dir, push);
+    list->moves[list->length] = '\0';
+    return true;
+}
+
+// Remove all moves from list, memory is kept for reuse
+void clearMoves(MoveList *list)
+{
+    list->length = 0;
+    if (list->moves != NULL)
+        list->moves[0] = '\0';
+}
+
+// Free memory used by move list
+void freeMoves(MoveList *list)
+{
+    free(list->moves);
+    initMoves(list);
+}
+
+// Apply LURD moves to level using play rules
+// Level must not contain player tile, player position is stored separately
+// Whitespace is skipped, replay stops at first error
+// Result: 0 - success, 1 - invalid character, 2 - blocked move, 3 - push does not match LURD case
+ReplayResult replayMoves(Level *level, Coordinates *player, char *lurd)
+{
+    ReplayResult result = {0, 0, 0, false};
+
+    for (char *c = lurd; *c != '\0'; c++)
+    {
+        if (*c == ' ' || *c == '\n' || *c == '\r' || *c == '\t')
+            continue;
+        bool push;
+        int dir = charToMove(*c, &push);
+        if (dir == -1)
+        {
+            result.result = 1;
+            break;
+        }
+        MoveResult move = movePlayer(level, player, dir);
+        if (move == blockedM)
+        {
+            result.result = 2;
+            break;
+        }
+        if ((move == pushedM) != push)
+        {
+            result.result = 3;
+            break;
+        }
+        result.moves++;
+        if (push)
+            result.pushes++;
+    }
+
+    result.finished = levelFinished(level);
+    return result;
+}
+
+// Replay solution on a copy of level, level itself is not modified
+// Level must contain exactly one player
+// Result: same as replayMoves, 4 - level has no player, 5 - failed to allocate memory
+// Solution is valid if result is 0 and level is finished
+ReplayResult verifySolution(Level *level, char *lurd)
+{
+    ReplayResult result = {0, 0, 0, false};
+    Level copy = *level;
+    Coordinates player;
+
+    copy.tiles = (TileState *)malloc(sizeof(TileState) * level->size.x * level->size.y);
+    if (copy.tiles == NULL)
+    {
+        result.result = 5;
+        return result;
+    }
+    memcpy(copy.tiles, level->tiles, sizeof(TileState) * level->size.x * level->size.y);
+
+    if (takePlayer(&copy, &player))
+        result = replayMoves(&copy, &player, lurd);
+    else
+        result.result = 4;
+
+    free(copy.tiles);
+    return result;
+}
+
+// Load LURD string from file, line breaks and other whitespace are removed
+// Returns dinamically allocated string, must be freed after use
+// Returns NULL if file cannot be opened or memory allocation fails
+char *loadLurd(char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+        return NULL;
+
+    MoveList list;
+    initMoves(&list);
+    int c;
+    while ((c = fgetc(file)) != EOF)
+    {
+        bool push;
+        int dir = charToMove((char)c, &push);
+        if (dir == -1) // skip whitespace and other characters
+            continue;
+        if (!appendMove(&list, dir, push))
+        {
+            freeMoves(&list);
+            fclose(file);
+            return NULL;
+        }
+    }
+    fclose(file);
+
+    if (list.moves == NULL) // file has no moves, return empty string
+    {
+        list.moves = (char *)malloc(sizeof(char));
+        if (list.moves != NULL)
+            list.moves[0] = '\0';
+    }
+    return list.moves;
+}
+
+// Save LURD string to file, ending with newline
+// Returns true on success, false on failure
+bool saveLurd(char *lurd, char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+        return false;
+
+    fprintf(file, "%s\n", lurd);
+
+    return fclose(file) == 0;
+}
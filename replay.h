@@ -0,0 +1,37 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include "file.h"
+#include "coordinates.h"
+
+typedef struct MoveList
+{
+    char *moves; // LURD string, always terminated
+    int length;
+    int capacity;
+} MoveList;
+
+typedef struct ReplayResult
+{
+    int result;
+    int moves;
+    int pushes;
+    bool finished;
+} ReplayResult;
+
+char moveToChar(int dir, bool push);
+int charToMove(char c, bool *push);
+
+void initMoves(MoveList *list);
+bool appendMove(MoveList *list, int dir, bool push);
+void clearMoves(MoveList *list);
+void freeMoves(MoveList *list);
+
+ReplayResult replayMoves(Level *level, Coordinates *player, char *lurd);
+ReplayResult verifySolution(Level *level, char *lurd);
+
+char *loadLurd(char *filename);
+bool saveLurd(char *lurd, char *filename);
+
+#endif
@@ -0,0 +1,1001 @@
+#include "solver.h"
+#include "file.h"
+#include "path.h"
+#include "move.h"
+#include "replay.h"
+#include "coordinates.h"
+#include "spill.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+#define SPILL_MEMORY ((size_t)256 << 20) // bytes of new positions sorted at once in disk search
+
+#ifdef DEBUGMALLOC
+#define MAX_BLOCK DEBUGMALLOC_BLOCK_SIZE // debugmalloc aborts on larger blocks, searches needing them run out of memory instead
+#else
+#define MAX_BLOCK SIZE_MAX
+#endif
+
+// Coordinate offsets for each direction
+// Direction: 0 - left, 1 - up, 2 - right, 3 - down
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+// Goal room: area holding every target, entered only through the entrance tile
+// Crates are pushed in from the entrance in a fixed packing order, each along a precomputed path
+typedef struct Room
+{
+    int entrance;  // tile outside of room, -1 if level has no goal room
+    int door;      // direction of pushes from entrance into room
+    bool *inside;  // tiles of room
+    int count;     // number of targets
+    int *order;    // targets in packing order
+    int **paths;   // moves from behind entrance that push crate to target, other crates of order before it are in place
+    int *lengths;  // number of moves of paths
+    int *ends;     // tile of player after path
+} Room;
+
+// Search over positions of crates, where only pushes count as steps
+// Positions are stored as bit sets of crate tiles and the top left tile the player can reach
+// Position storage is also the queue of the breadth first search, so solutions have the least pushes, or macro moves
+typedef struct Search
+{
+    Level *level;
+    int count;         // number of tiles
+    int words;         // number of 64 bit words in a crate set
+    bool *live;        // tiles from where a crate can still reach a target
+    bool surplus;      // more crates than targets, crates may stay off targets, so they are never dead
+    bool macros;       // tunnel and goal room macro moves are used
+    uint64_t *targets; // set of target tiles
+    uint64_t *crates;  // crate sets of positions
+    int *player;       // top left reachable tile of positions
+    int *parent;       // index of previous position
+    int *push;         // pushed crate tile * 4 + direction of first push that led to position
+    long nodes;
+    long capacity;
+    long *table; // hash table of position index + 1, 0 is empty
+    long tableSize;
+    int *queue;    // work area for reachability
+    bool *reached; // tiles reached by player in expanded position
+    bool *scratch; // tiles reached by player in new position
+    Room room;
+    uint64_t *children; // crate sets of positions made by expandPosition
+    int *childAreas;    // their top left reachable tiles
+    int *childPushes;   // and pushes leading to them
+} Search;
+
+// Get current time in seconds
+static double now(void)
+{
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// Check if tile can never be entered by player or crate
+static bool isWall(Level *level, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= level->size.x || y >= level->size.y)
+        return true;
+    TileState tile = level->tiles[x + y * level->size.x];
+    return tile == wallS || tile == invalidS;
+}
+
+// Check if tile is a target
+static bool isTarget(TileState tile)
+{
+    return tile == targetS || tile == crateOnTargetS || tile == playerOnTargetS;
+}
+
+// Find tiles from where a crate can be pushed to a target when no other crates are in the way
+// Crates on other tiles are in a dead position, live must be able to hold a value for every tile
+// Returns false on memory allocation failure
+bool findLiveTiles(Level *level, bool *live)
+{
+    int count = level->size.x * level->size.y;
+    int *queue = (int *)malloc(sizeof(int) * count);
+    if (queue == NULL)
+        return false;
+
+    int head = 0;
+    int tail = 0;
+    for (int i = 0; i < count; i++)
+    {
+        live[i] = isTarget(level->tiles[i]);
+        if (live[i])
+            queue[tail++] = i;
+    }
+
+    while (head < tail) // pull crates backwards from targets
+    {
+        int x = queue[head] % level->size.x;
+        int y = queue[head] / level->size.x;
+        head++;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int x1 = x + dirX[dir]; // crate is pulled here
+            int y1 = y + dirY[dir];
+            int x2 = x1 + dirX[dir]; // player stands here after pulling
+            int y2 = y1 + dirY[dir];
+            if (!isWall(level, x1, y1) && !isWall(level, x2, y2) && !live[x1 + y1 * level->size.x])
+            {
+                live[x1 + y1 * level->size.x] = true;
+                queue[tail++] = x1 + y1 * level->size.x;
+            }
+        }
+    }
+
+    free(queue);
+    return true;
+}
+
+// Check if crate set contains tile
+static bool hasCrate(uint64_t *crates, int tile)
+{
+    return (crates[tile / 64] >> (tile % 64)) & 1;
+}
+
+// Check if tile is blocked for walking in position
+static bool isBlocked(Search *search, uint64_t *crates, int x, int y)
+{
+    return isWall(search->level, x, y) || hasCrate(crates, x + y * search->level->size.x);
+}
+
+// Find tiles player can reach from start tile
+// Returns top left reachable tile, which identifies the area of player
+static int findReachable(Search *search, uint64_t *crates, int start, bool *reached)
+{
+    Level *level = search->level;
+    memset(reached, 0, sizeof(bool) * search->count);
+    int head = 0;
+    int tail = 0;
+    int first = start;
+    search->queue[tail++] = start;
+    reached[start] = true;
+    while (head < tail)
+    {
+        int x = search->queue[head] % level->size.x;
+        int y = search->queue[head] / level->size.x;
+        head++;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int nx = x + dirX[dir];
+            int ny = y + dirY[dir];
+            int next = nx + ny * level->size.x;
+            if (!isBlocked(search, crates, nx, ny) && !reached[next])
+            {
+                reached[next] = true;
+                search->queue[tail++] = next;
+                if (next < first)
+                    first = next;
+            }
+        }
+    }
+    return first;
+}
+
+// Check if crate pushed to tile got stuck in a 2x2 block of walls and crates
+// Block is only a deadlock if one of its crates is not on a target and every crate has to reach a target
+static bool isBlockDeadlock(Search *search, uint64_t *crates, int tile)
+{
+    if (search->surplus)
+        return false;
+    Level *level = search->level;
+    int x = tile % level->size.x;
+    int y = tile / level->size.x;
+    for (int dx = -1; dx <= 0; dx++)
+    {
+        for (int dy = -1; dy <= 0; dy++)
+        {
+            bool blocked = true;
+            bool misplaced = false;
+            for (int i = 0; i < 4 && blocked; i++)
+            {
+                int bx = x + dx + i % 2;
+                int by = y + dy + i / 2;
+                if (isWall(level, bx, by))
+                    continue;
+                if (!hasCrate(crates, bx + by * level->size.x))
+                    blocked = false;
+                else if (!isTarget(level->tiles[bx + by * level->size.x]))
+                    misplaced = true;
+            }
+            if (blocked && misplaced)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Hash crate set and player tile of position
+static uint64_t hashPosition(Search *search, uint64_t *crates, int player)
+{
+    uint64_t hash = 14695981039346656037ULL ^ (uint64_t)player;
+    for (int i = 0; i < search->words; i++)
+    {
+        hash ^= crates[i];
+        hash *= 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// Find stored position in hash table
+// Returns slot of position, or the empty slot where it should be stored
+static long findSlot(Search *search, uint64_t *crates, int player)
+{
+    long slot = hashPosition(search, crates, player) & (search->tableSize - 1);
+    while (search->table[slot] != 0)
+    {
+        long node = search->table[slot] - 1;
+        if (search->player[node] == player && memcmp(search->crates + node * search->words, crates, sizeof(uint64_t) * search->words) == 0)
+            return slot;
+        slot = (slot + 1) & (search->tableSize - 1);
+    }
+    return slot;
+}
+
+// Double size of hash table and insert every stored position again
+// Returns false on memory allocation failure
+static bool growTable(Search *search)
+{
+    long size = search->tableSize == 0 ? 1024 : search->tableSize * 2;
+    if ((size_t)size > MAX_BLOCK / sizeof(long))
+        return false;
+    long *table = (long *)calloc(size, sizeof(long));
+    if (table == NULL)
+        return false;
+    free(search->table);
+    search->table = table;
+    search->tableSize = size;
+    for (long i = 0; i < search->nodes; i++)
+        search->table[findSlot(search, search->crates + i * search->words, search->player[i])] = i + 1;
+    return true;
+}
+
+// Store new position at the end of the queue
+// Returns index of position, -1 on memory allocation failure
+static long addPosition(Search *search, uint64_t *crates, int player, long parent, int push)
+{
+    if (search->nodes == search->capacity) // grow position storage
+    {
+        long capacity = search->capacity == 0 ? 1024 : search->capacity * 2;
+        if ((size_t)capacity > MAX_BLOCK / (sizeof(uint64_t) * search->words)) // crates are the largest of the arrays
+            return -1;
+        uint64_t *newCrates = (uint64_t *)realloc(search->crates, sizeof(uint64_t) * search->words * capacity);
+        if (newCrates == NULL)
+            return -1;
+        search->crates = newCrates;
+        int *arrays[3] = {search->player, search->parent, search->push};
+        for (int i = 0; i < 3; i++)
+        {
+            int *array = (int *)realloc(arrays[i], sizeof(int) * capacity);
+            if (array == NULL)
+                return -1;
+            arrays[i] = array;
+            if (i == 0)
+                search->player = array;
+            else if (i == 1)
+                search->parent = array;
+            else
+                search->push = array;
+        }
+        search->capacity = capacity;
+    }
+    if (search->nodes * 2 >= search->tableSize && !growTable(search))
+        return -1;
+
+    long node = search->nodes++;
+    memcpy(search->crates + node * search->words, crates, sizeof(uint64_t) * search->words);
+    search->player[node] = player;
+    search->parent[node] = parent;
+    search->push[node] = push;
+    search->table[findSlot(search, crates, player)] = node + 1;
+    return node;
+}
+
+// Check if every target is covered by a crate
+static bool isSolved(Search *search, uint64_t *crates)
+{
+    for (int i = 0; i < search->words; i++)
+    {
+        if ((search->targets[i] & ~crates[i]) != 0)
+            return false;
+    }
+    return true;
+}
+
+// Free memory used by search
+static void freeSearch(Search *search)
+{
+    free(search->live);
+    free(search->targets);
+    free(search->crates);
+    free(search->player);
+    free(search->parent);
+    free(search->push);
+    free(search->table);
+    free(search->queue);
+    free(search->reached);
+    free(search->scratch);
+    free(search->children);
+    free(search->childAreas);
+    free(search->childPushes);
+    for (int i = 0; i < search->room.count && search->room.paths != NULL; i++)
+        free(search->room.paths[i]);
+    free(search->room.inside);
+    free(search->room.order);
+    free(search->room.paths);
+    free(search->room.lengths);
+    free(search->room.ends);
+}
+
+// Check if tile has walls on both sides perpendicular to direction
+static bool isTunnel(Level *level, int tile, int dir)
+{
+    int x = tile % level->size.x;
+    int y = tile / level->size.x;
+    return isWall(level, x + dirY[dir], y + dirX[dir]) && isWall(level, x - dirY[dir], y - dirX[dir]);
+}
+
+// Follow crate pushed to tile through a one wide tunnel, while the player behind it is also in the tunnel
+// Crate stops on targets, at the entrance of the goal room and before tiles it cannot be pushed to
+// Returns tile where crate stops
+static int followTunnel(Search *search, uint64_t *crates, int tile, int dir)
+{
+    Level *level = search->level;
+    int step = dirX[dir] + dirY[dir] * level->size.x;
+    while (!isTarget(level->tiles[tile]) && tile != search->room.entrance && isTunnel(level, tile, dir) && isTunnel(level, tile - step, dir))
+    {
+        int x = tile % level->size.x + dirX[dir];
+        int y = tile / level->size.x + dirY[dir];
+        if (isBlocked(search, crates, x, y) || !search->live[x + y * level->size.x])
+            break;
+        tile += step;
+    }
+    return tile;
+}
+
+// Flood fill area connected to start tile without entering walls and the excluded tile
+// Returns number of tiles in area
+static int fillArea(Search *search, int start, int excluded, bool *area)
+{
+    Level *level = search->level;
+    memset(area, 0, sizeof(bool) * search->count);
+    int head = 0;
+    int tail = 0;
+    search->queue[tail++] = start;
+    area[start] = true;
+    while (head < tail)
+    {
+        int x = search->queue[head] % level->size.x;
+        int y = search->queue[head] / level->size.x;
+        head++;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int next = x + dirX[dir] + (y + dirY[dir]) * level->size.x;
+            if (!isWall(level, x + dirX[dir], y + dirY[dir]) && next != excluded && !area[next])
+            {
+                area[next] = true;
+                search->queue[tail++] = next;
+            }
+        }
+    }
+    return tail;
+}
+
+// Check if area cut off by entrance can be a goal room
+// It must hold every target but neither the player nor crates, and be entered through a single door
+// Returns direction of door from entrance, -1 if area is not a goal room
+static int findDoor(Search *search, bool *area, int entrance, int player, uint64_t *crates)
+{
+    Level *level = search->level;
+    for (int i = 0; i < search->count; i++)
+    {
+        if (isTarget(level->tiles[i]) != area[i] && isTarget(level->tiles[i]))
+            return -1;
+        if (area[i] && (i == player || hasCrate(crates, i)))
+            return -1;
+    }
+    int door = -1;
+    int x = entrance % level->size.x;
+    int y = entrance / level->size.x;
+    for (int dir = 0; dir < 4; dir++)
+    {
+        if (isWall(level, x + dirX[dir], y + dirY[dir]) || !area[entrance + dirX[dir] + dirY[dir] * level->size.x])
+            continue;
+        if (door != -1)
+            return -1;
+        door = dir;
+    }
+    if (door == -1 || isWall(level, x - dirX[door], y - dirY[door])) // player must be able to push through the door
+        return -1;
+    return door;
+}
+
+// Find order of filling targets of goal room, where every crate can still be pushed in from the entrance
+// Targets are taken out of the full room backwards, one that can be filled last with the others in place
+// Returns false on memory allocation failure, entrance of room is set to -1 if there is no order
+static bool findPackingOrder(Search *search)
+{
+    Level *level = search->level;
+    Room *room = &search->room;
+    int behind = room->entrance - dirX[room->door] - dirY[room->door] * level->size.x;
+    Level scratch = *level;
+    scratch.tiles = (TileState *)malloc(sizeof(TileState) * search->count);
+    bool *filled = (bool *)malloc(sizeof(bool) * search->count);
+    if (scratch.tiles == NULL || filled == NULL)
+    {
+        free(scratch.tiles);
+        free(filled);
+        return false;
+    }
+    for (int i = 0; i < search->count; i++)
+        filled[i] = isTarget(level->tiles[i]);
+
+    bool success = true;
+    for (int k = room->count - 1; k >= 0 && room->entrance != -1 && success; k--)
+    {
+        bool found = false;
+        for (int target = 0; target < search->count && !found && success; target++)
+        {
+            if (!filled[target])
+                continue;
+            for (int i = 0; i < search->count; i++) // only the room and the tiles in front of it can be used
+            {
+                if (!room->inside[i] && i != room->entrance && i != behind)
+                    scratch.tiles[i] = wallS;
+                else if (filled[i] && i != target)
+                    scratch.tiles[i] = crateOnTargetS;
+                else
+                    scratch.tiles[i] = isTarget(level->tiles[i]) ? targetS : floorTileS;
+            }
+            scratch.tiles[room->entrance] = crateS;
+            Coordinates player = {behind % level->size.x, behind / level->size.x};
+            Coordinates from = {room->entrance % level->size.x, room->entrance / level->size.x};
+            Coordinates to = {target % level->size.x, target / level->size.x};
+            int length = findPushPath(&scratch, player, from, to, &room->paths[k]);
+            if (length == -2)
+                success = false;
+            else if (length > 0)
+            {
+                found = true;
+                filled[target] = false;
+                room->order[k] = target;
+                room->lengths[k] = length;
+                room->ends[k] = behind;
+                for (int i = 0; i < length; i++) // player follows every move of path
+                    room->ends[k] += dirX[room->paths[k][i]] + dirY[room->paths[k][i]] * level->size.x;
+            }
+        }
+        if (!found)
+            room->entrance = -1; // targets cannot be filled from the entrance, search without goal room
+    }
+
+    free(scratch.tiles);
+    free(filled);
+    return success;
+}
+
+// Find the smallest goal room holding every target and its packing order
+// Entrance of room is set to -1 if level has no goal room
+// Returns false on memory allocation failure
+static bool findRoom(Search *search, int player, uint64_t *crates)
+{
+    Level *level = search->level;
+    Room *room = &search->room;
+    room->entrance = -1;
+    room->count = 0;
+    int firstTarget = -1;
+    for (int i = 0; i < search->count; i++)
+    {
+        if (isTarget(level->tiles[i]))
+        {
+            room->count++;
+            if (firstTarget == -1)
+                firstTarget = i;
+        }
+    }
+    if (firstTarget == -1 || !search->macros || search->surplus) // surplus crates might have to be parked in the room
+        return true;
+    bool *area = (bool *)malloc(sizeof(bool) * search->count);
+    room->inside = (bool *)malloc(sizeof(bool) * search->count);
+    room->order = (int *)malloc(sizeof(int) * room->count);
+    room->paths = (int **)calloc(room->count, sizeof(int *));
+    room->lengths = (int *)malloc(sizeof(int) * room->count);
+    room->ends = (int *)malloc(sizeof(int) * room->count);
+    if (area == NULL || room->inside == NULL || room->order == NULL || room->paths == NULL || room->lengths == NULL || room->ends == NULL)
+    {
+        free(area);
+        return false;
+    }
+
+    int smallest = search->count;
+    for (int entrance = 0; entrance < search->count; entrance++)
+    {
+        if (isWall(level, entrance % level->size.x, entrance / level->size.x) || isTarget(level->tiles[entrance]))
+            continue;
+        int size = fillArea(search, firstTarget, entrance, area);
+        if (size >= smallest)
+            continue;
+        int door = findDoor(search, area, entrance, player, crates);
+        if (door == -1)
+            continue;
+        smallest = size;
+        room->entrance = entrance;
+        room->door = door;
+        memcpy(room->inside, area, sizeof(bool) * search->count);
+    }
+    free(area);
+    return room->entrance == -1 || findPackingOrder(search);
+}
+
+// Count crates packed into goal room
+static int countPacked(Search *search, uint64_t *crates)
+{
+    int packed = 0;
+    for (int i = 0; i < search->room.count; i++)
+        packed += hasCrate(crates, search->room.order[i]);
+    return packed;
+}
+
+// Find tile where the crate moved to position from its parent stands
+static int findMovedCrate(Search *search, long node)
+{
+    uint64_t *crates = search->crates + node * search->words;
+    uint64_t *previous = search->crates + search->parent[node] * search->words;
+    for (int tile = 0; tile < search->count; tile++)
+    {
+        if (hasCrate(crates, tile) && !hasCrate(previous, tile))
+            return tile;
+    }
+    return -1;
+}
+
+// Make move of solution on copy of level and record it
+// Returns result of move, blockedM on memory allocation failure
+static MoveResult replayMove(Level *copy, Coordinates *player, int dir, MoveList *moves)
+{
+    MoveResult moved = movePlayer(copy, player, dir);
+    if (moved != blockedM && !appendMove(moves, dir, moved == pushedM))
+        return blockedM;
+    return moved;
+}
+
+// Turn pushes leading to position into LURD string, including walks between pushes
+// Macro moves are expanded: tunnel pushes are repeated until the crate reaches its tile, crates entering the goal room follow their path
+// Returns false on memory allocation failure or if pushes cannot be replayed
+static bool buildSolution(Search *search, long node, SolverResult *result)
+{
+    Level *level = search->level;
+    Room *room = &search->room;
+    int steps = 0;
+    for (long i = node; i != 0; i = search->parent[i])
+        steps++;
+    long *order = (long *)malloc(sizeof(long) * (steps + 1));
+    int *walk = (int *)malloc(sizeof(int) * search->count);
+    Level copy = *level;
+    copy.tiles = (TileState *)malloc(sizeof(TileState) * search->count);
+    MoveList moves;
+    initMoves(&moves);
+    int pushes = 0;
+    bool success = order != NULL && walk != NULL && copy.tiles != NULL;
+
+    if (success)
+    {
+        int index = steps;
+        for (long i = node; i != 0; i = search->parent[i])
+            order[--index] = i;
+        memcpy(copy.tiles, level->tiles, sizeof(TileState) * search->count);
+        Coordinates player;
+        success = takePlayer(&copy, &player);
+
+        for (int i = 0; i < steps && success; i++) // walk behind crate, then push it
+        {
+            int crate = search->push[order[i]] / 4;
+            int dir = search->push[order[i]] % 4;
+            int destination = findMovedCrate(search, order[i]);
+            Coordinates behind = {crate % level->size.x - dirX[dir], crate / level->size.x - dirY[dir]};
+            int length = findPath(&copy, player, behind, walk, search->count);
+            success = length >= 0;
+            for (int j = 0; j < length && success; j++)
+                success = replayMove(&copy, &player, walk[j], &moves) == walkedM;
+
+            if (crate == room->entrance && dir == room->door) // macro move into goal room
+            {
+                int k = 0;
+                while (k < room->count && room->order[k] != destination)
+                    k++;
+                success = success && k < room->count;
+                for (int j = 0; success && j < room->lengths[k]; j++)
+                {
+                    MoveResult moved = replayMove(&copy, &player, room->paths[k][j], &moves);
+                    success = moved != blockedM;
+                    pushes += moved == pushedM;
+                }
+            }
+            else // single push or pushes through a tunnel
+            {
+                int step = dirX[dir] + dirY[dir] * level->size.x;
+                for (int tile = crate; tile != destination && success; tile += step)
+                {
+                    success = replayMove(&copy, &player, dir, &moves) == pushedM;
+                    pushes++;
+                }
+            }
+        }
+    }
+
+    if (success && moves.moves == NULL) // level was already solved
+    {
+        moves.moves = (char *)malloc(sizeof(char));
+        success = moves.moves != NULL;
+        if (success)
+            moves.moves[0] = '\0';
+    }
+    if (success)
+    {
+        result->solution = moves.moves;
+        result->moves = moves.length;
+        result->pushes = pushes;
+    }
+    else
+        freeMoves(&moves);
+
+    free(order);
+    free(walk);
+    free(copy.tiles);
+    return success;
+}
+
+// Find positions reached from position by a push or a macro move, dead positions are left out
+// Crate sets of new positions are written to search->children, player areas and pushes to childAreas and childPushes
+// Returns number of new positions
+static int expandPosition(Search *search, uint64_t *crates, int player)
+{
+    Level *level = search->level;
+    Room *room = &search->room;
+    int count = 0;
+    findReachable(search, crates, player, search->reached);
+    for (int crate = 0; crate < search->count; crate++)
+    {
+        if (!hasCrate(crates, crate) || (room->entrance != -1 && room->inside[crate])) // crates packed into goal room stay there
+            continue;
+        int x = crate % level->size.x;
+        int y = crate / level->size.x;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int bx = x - dirX[dir]; // player stands behind crate
+            int by = y - dirY[dir];
+            int tx = x + dirX[dir]; // crate moves here
+            int ty = y + dirY[dir];
+            if (isWall(level, bx, by) || !search->reached[bx + by * level->size.x] || isBlocked(search, crates, tx, ty) || !search->live[tx + ty * level->size.x])
+                continue;
+
+            int moved;      // tile where crate stops
+            int playerTile; // player stands behind it
+            if (crate == room->entrance && dir == room->door) // macro move, crate is pushed to the next target of packing order
+            {
+                int packed = countPacked(search, crates);
+                if (packed == room->count)
+                    continue;
+                moved = room->order[packed];
+                playerTile = room->ends[packed];
+            }
+            else // crate pushed into a tunnel is pushed through it with macro moves
+            {
+                moved = search->macros ? followTunnel(search, crates, tx + ty * level->size.x, dir) : tx + ty * level->size.x;
+                playerTile = moved - dirX[dir] - dirY[dir] * level->size.x;
+            }
+
+            uint64_t *next = search->children + count * search->words;
+            memcpy(next, crates, sizeof(uint64_t) * search->words);
+            next[crate / 64] &= ~(1ULL << (crate % 64));
+            next[moved / 64] |= 1ULL << (moved % 64);
+            if (isBlockDeadlock(search, next, moved))
+                continue;
+            search->childAreas[count] = findReachable(search, next, playerTile, search->scratch);
+            search->childPushes[count] = crate * 4 + dir;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Check if search has to stop
+// Returns 1 if search can go on, 2 if time limit was reached, 3 if it was cancelled
+static int checkLimits(SolverLimits limits, double start)
+{
+    if (limits.cancel != NULL && atomic_load(limits.cancel) != 0)
+        return 3;
+    if (limits.maxSeconds > 0 && now() - start > limits.maxSeconds)
+        return 2;
+    return 1;
+}
+
+// Breadth first search with every position kept in memory
+// Returns index of solved position, -1 if it was not found, result code is set
+static long searchInMemory(Search *search, uint64_t *crates, int area, SolverLimits limits, double start, SolverResult *result)
+{
+    long found = -1;
+    if (addPosition(search, crates, area, 0, 0) == -1)
+        result->result = 5;
+    else if (isSolved(search, crates))
+        found = 0;
+
+    for (long head = 0; head < search->nodes && found == -1 && result->result == 1; head++)
+    {
+        if ((head & 255) == 0 && (result->result = checkLimits(limits, start)) != 1) // check limits from time to time
+            break;
+
+        int children = expandPosition(search, search->crates + head * search->words, search->player[head]);
+        for (int i = 0; i < children && found == -1; i++)
+        {
+            uint64_t *next = search->children + i * search->words;
+            if (search->table[findSlot(search, next, search->childAreas[i])] != 0) // already visited
+                continue;
+            if (limits.maxNodes > 0 && search->nodes >= limits.maxNodes)
+            {
+                result->result = 2;
+                break;
+            }
+            long node = addPosition(search, next, search->childAreas[i], head, search->childPushes[i]);
+            if (node == -1)
+            {
+                result->result = 5;
+                break;
+            }
+            if (isSolved(search, next))
+                found = node;
+        }
+    }
+    result->nodes = search->nodes;
+    return found;
+}
+
+// Write position to record of disk search: crate set and player area as key, then push and index of parent in previous layer
+static void packRecord(Search *search, unsigned char *record, uint64_t *crates, int32_t area, int32_t push, int64_t parent)
+{
+    size_t size = sizeof(uint64_t) * search->words;
+    memcpy(record, crates, size);
+    memcpy(record + size, &area, sizeof(int32_t));
+    memcpy(record + size + sizeof(int32_t), &push, sizeof(int32_t));
+    memcpy(record + size + 2 * sizeof(int32_t), &parent, sizeof(int64_t));
+}
+
+// Read position from record of disk search, see packRecord
+static void unpackRecord(Search *search, unsigned char *record, uint64_t *crates, int32_t *area, int32_t *push, int64_t *parent)
+{
+    size_t size = sizeof(uint64_t) * search->words;
+    memcpy(crates, record, size);
+    memcpy(area, record + size, sizeof(int32_t));
+    memcpy(push, record + size + sizeof(int32_t), sizeof(int32_t));
+    memcpy(parent, record + size + 2 * sizeof(int32_t), sizeof(int64_t));
+}
+
+// Copy path from root to solved position out of layer files into position storage of search, so buildSolution can use it
+// Solved position is in record, which is not stored in any layer yet
+// Returns index of solved position, -1 on failure
+static long copyPath(Search *search, Spill *spill, int layers, unsigned char *record)
+{
+    long steps = layers + 1;
+    int recordSize = sizeof(uint64_t) * search->words + 2 * sizeof(int32_t) + sizeof(int64_t);
+    unsigned char *path = (unsigned char *)malloc((size_t)recordSize * steps);
+    if (path == NULL)
+        return -1;
+    memcpy(path + layers * recordSize, record, recordSize);
+    bool success = true;
+    for (int layer = layers - 1; layer >= 0 && success; layer--) // follow parents backwards
+    {
+        int64_t parent;
+        memcpy(&parent, path + (layer + 1) * recordSize + recordSize - sizeof(int64_t), sizeof(int64_t));
+        unsigned char *records;
+        long count;
+        success = mapLayer(spill, layer, &records, &count) && parent < count;
+        if (success)
+            memcpy(path + layer * recordSize, records + parent * recordSize, recordSize);
+        unmapLayer(spill, records, count);
+    }
+
+    long node = -1;
+    uint64_t *crates = search->children; // only work area, nothing is expanded any more
+    for (long i = 0; i < steps && success; i++)
+    {
+        int32_t area, push;
+        int64_t parent;
+        unpackRecord(search, path + i * recordSize, crates, &area, &push, &parent);
+        node = addPosition(search, crates, area, node == -1 ? 0 : node, push);
+        success = node != -1;
+    }
+    free(path);
+    return success ? node : -1;
+}
+
+// Breadth first search with positions kept in files of limits.spillDirectory, one layer of pushes at a time
+// Positions reached from a layer are collected in sorted batches, duplicates are removed when the layer is finished,
+// so memory use does not depend on the number of positions
+// Returns index of solved position copied to search, -1 if it was not found, result code is set
+static long searchOnDisk(Search *search, uint64_t *crates, int area, SolverLimits limits, double start, SolverResult *result)
+{
+    int keySize = sizeof(uint64_t) * search->words + sizeof(int32_t);
+    int recordSize = keySize + sizeof(int32_t) + sizeof(int64_t);
+    Spill *spill = openSpill(limits.spillDirectory, recordSize, keySize, SPILL_MEMORY < MAX_BLOCK ? SPILL_MEMORY : MAX_BLOCK);
+    unsigned char *record = (unsigned char *)malloc(recordSize);
+    uint64_t *current = (uint64_t *)malloc(sizeof(uint64_t) * search->words);
+    if (spill == NULL || record == NULL || current == NULL)
+    {
+        result->result = 5;
+        closeSpill(spill);
+        free(record);
+        free(current);
+        return -1;
+    }
+
+    long found = -1;
+    long stored = 1;
+    int depth = 0; // pushes or macro moves to solved position
+    bool solved = isSolved(search, crates);
+    packRecord(search, record, crates, area, 0, 0);
+    if (!solved && (!addRecord(spill, record) || finishLayer(spill) != 1))
+        result->result = 6;
+
+    for (int layer = 0; !solved && result->result == 1; layer++)
+    {
+        unsigned char *records;
+        long count;
+        if (!mapLayer(spill, layer, &records, &count))
+        {
+            result->result = 6;
+            break;
+        }
+        for (long i = 0; i < count && !solved && result->result == 1; i++)
+        {
+            if ((i & 255) == 0 && (result->result = checkLimits(limits, start)) != 1) // check limits from time to time
+                break;
+            int32_t player, push;
+            int64_t parent;
+            unpackRecord(search, records + i * recordSize, current, &player, &push, &parent);
+            int children = expandPosition(search, current, player);
+            for (int j = 0; j < children && !solved && result->result == 1; j++)
+            {
+                uint64_t *next = search->children + j * search->words;
+                packRecord(search, record, next, search->childAreas[j], search->childPushes[j], i);
+                if (isSolved(search, next))
+                {
+                    solved = true;
+                    depth = layer + 1;
+                }
+                else if (!addRecord(spill, record))
+                    result->result = 6;
+            }
+        }
+        unmapLayer(spill, records, count);
+        if (solved || result->result != 1)
+            break;
+
+        long added = finishLayer(spill);
+        if (added == -1)
+            result->result = 6;
+        else if (added == 0) // every reachable position was visited
+            break;
+        stored += added;
+        if (limits.maxNodes > 0 && stored >= limits.maxNodes)
+            result->result = 2;
+    }
+
+    if (solved)
+    {
+        found = copyPath(search, spill, depth, record);
+        if (found == -1)
+            result->result = 5;
+    }
+    result->nodes = stored;
+    closeSpill(spill);
+    free(record);
+    free(current);
+    return found;
+}
+
+// Solve level with breadth first search over pushes
+// Solution has the least possible pushes, but not necessarily the least moves
+// With limits.macros pushes through tunnels and into the goal room take a single step of the search,
+// which needs far fewer positions on levels with corridors, but pushes are not necessarily the least possible
+// Positions are kept in memory, or in files of limits.spillDirectory for levels needing more positions than fit in memory
+// Result: 0 - solved, 1 - level has no solution, 2 - limit reached, 3 - cancelled, 4 - invalid level, 5 - memory allocation failure,
+// 6 - files of positions cannot be written
+// Solution is dinamically allocated, use freeSolverResult after use
+SolverResult solveLevel(Level *level, SolverLimits limits)
+{
+    SolverResult result = {0, NULL, 0, 0, 0, 0};
+    double start = now();
+    Search search;
+    memset(&search, 0, sizeof(Search));
+    search.level = level;
+    search.macros = limits.macros;
+    search.count = level->size.x * level->size.y;
+    search.words = (search.count + 63) / 64;
+    search.live = (bool *)malloc(sizeof(bool) * search.count);
+    search.targets = (uint64_t *)calloc(search.words, sizeof(uint64_t));
+    search.queue = (int *)malloc(sizeof(int) * search.count);
+    search.reached = (bool *)malloc(sizeof(bool) * search.count);
+    search.scratch = (bool *)malloc(sizeof(bool) * search.count);
+    search.children = (uint64_t *)malloc(sizeof(uint64_t) * search.words * search.count * 4); // every crate can be pushed in 4 directions
+    search.childAreas = (int *)malloc(sizeof(int) * search.count * 4);
+    search.childPushes = (int *)malloc(sizeof(int) * search.count * 4);
+    uint64_t *crates = (uint64_t *)calloc(search.words, sizeof(uint64_t)); // root position
+    if (search.live == NULL || search.targets == NULL || search.queue == NULL || search.reached == NULL || search.scratch == NULL ||
+        search.children == NULL || search.childAreas == NULL || search.childPushes == NULL || crates == NULL || !findLiveTiles(level, search.live))
+    {
+        result.result = 5;
+        free(crates);
+        freeSearch(&search);
+        return result;
+    }
+    int player = -1; // collect root position
+    int crateCount = 0;
+    int targetCount = 0;
+    for (int i = 0; i < search.count; i++)
+    {
+        TileState tile = level->tiles[i];
+        if (tile == playerS || tile == playerOnTargetS)
+            player = player == -1 ? i : -2;
+        if (tile == crateS || tile == crateOnTargetS)
+        {
+            crates[i / 64] |= 1ULL << (i % 64);
+            crateCount++;
+        }
+        if (isTarget(tile))
+        {
+            search.targets[i / 64] |= 1ULL << (i % 64);
+            targetCount++;
+        }
+    }
+    if (player < 0 || crateCount < targetCount)
+    {
+        result.result = 4;
+        free(crates);
+        freeSearch(&search);
+        return result;
+    }
+    search.surplus = crateCount > targetCount;
+    for (int i = 0; i < search.count && search.surplus; i++) // dead tiles are only dead if every crate needs a target
+        search.live[i] = true;
+
+    if (!findRoom(&search, player, crates))
+    {
+        result.result = 5;
+        free(crates);
+        freeSearch(&search);
+        return result;
+    }
+    long found = -1;
+    result.result = 1;
+    int area = findReachable(&search, crates, player, search.reached);
+    if (limits.spillDirectory != NULL)
+        found = searchOnDisk(&search, crates, area, limits, start, &result);
+    else
+        found = searchInMemory(&search, crates, area, limits, start, &result);
+
+    if (found != -1)
+        result.result = buildSolution(&search, found, &result) ? 0 : 5;
+    result.seconds = now() - start;
+    free(crates);
+    freeSearch(&search);
+    return result;
+}
+
+// Free solution of solver result
+void freeSolverResult(SolverResult *result)
+{
+    free(result->solution);
+    result->solution = NULL;
+}
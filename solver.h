@@ -0,0 +1,31 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "file.h"
+
+typedef struct SolverLimits
+{
+    long maxNodes;        // maximum number of stored positions, 0 for no limit
+    double maxSeconds;    // maximum time of search, 0 for no limit
+    atomic_int *cancel;   // search stops when another thread sets it to non-zero, can be NULL
+    char *spillDirectory; // positions are kept in files of this directory instead of memory, NULL to search in memory
+    bool macros;          // push through tunnels and into goal room in one step, fewer positions but pushes are not the least possible
+} SolverLimits;
+
+typedef struct SolverResult
+{
+    int result;
+    char *solution; // LURD string, NULL if level was not solved
+    int moves;
+    int pushes;
+    long nodes;
+    double seconds;
+} SolverResult;
+
+bool findLiveTiles(Level *level, bool *live);
+SolverResult solveLevel(Level *level, SolverLimits limits);
+void freeSolverResult(SolverResult *result);
+
+#endif
@@ -0,0 +1,260 @@
+#include "spill.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+// Fixed size records of a breadth first search stored in files, layer by layer
+// New records are buffered, sorted and written to run files, finishing a layer merges the runs,
+// removes duplicates and records already in the visited set, and adds the rest to the visited set
+// Files are read through memory mappings, so only the pages being used take memory
+struct Spill
+{
+    char *directory;
+    char *path; // buffer for file names
+    int id;     // unique number of spill, files of concurrent searches do not collide
+    int recordSize;
+    int keySize;           // records are ordered and compared by their first keySize bytes
+    unsigned char *buffer; // new records not written yet
+    long buffered;
+    long capacity;
+    int runs;   // sorted run files of the layer being built
+    int layers; // finished layers
+};
+
+static atomic_int nextId;
+
+// Key size of records being sorted, qsort has no argument for it
+static _Thread_local int sortKeySize;
+
+// Order records by key for qsort
+static int compareKeys(const void *a, const void *b)
+{
+    return memcmp(a, b, sortKeySize);
+}
+
+// Write name of file into spill->path
+// Kind: "run", "layer" or "visited", number: index of file of that kind
+static char *filePath(Spill *spill, char *kind, int number)
+{
+    sprintf(spill->path, "%s/sokoban-%d-%d-%s%d.tmp", spill->directory, (int)getpid(), spill->id, kind, number);
+    return spill->path;
+}
+
+// Map whole file into memory for reading
+// Data is NULL and count is 0 if file is empty
+// Returns false if file cannot be opened or mapped
+static bool mapFile(char *path, int recordSize, unsigned char **data, long *count)
+{
+    *data = NULL;
+    *count = 0;
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor == -1)
+        return false;
+    struct stat status;
+    bool success = fstat(descriptor, &status) == 0;
+    if (success && status.st_size > 0)
+    {
+        void *mapped = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        success = mapped != MAP_FAILED;
+        if (success)
+        {
+            madvise(mapped, status.st_size, MADV_SEQUENTIAL); // files are read from start to end
+            *data = (unsigned char *)mapped;
+            *count = status.st_size / recordSize;
+        }
+    }
+    close(descriptor);
+    return success;
+}
+
+// Release mapping of file
+static void unmapFile(unsigned char *data, long count, int recordSize)
+{
+    if (data != NULL)
+        munmap(data, (size_t)count * recordSize);
+}
+
+// Start storing records in files of directory
+// Memory: bytes of new records buffered before they are sorted and written
+// Returns NULL on memory allocation failure
+Spill *openSpill(char *directory, int recordSize, int keySize, size_t memory)
+{
+    Spill *spill = (Spill *)calloc(1, sizeof(Spill));
+    if (spill == NULL)
+        return NULL;
+    spill->directory = directory;
+    spill->id = atomic_fetch_add(&nextId, 1);
+    spill->recordSize = recordSize;
+    spill->keySize = keySize;
+    spill->capacity = memory / recordSize > 0 ? memory / recordSize : 1;
+    spill->path = (char *)malloc(strlen(directory) + 64);
+    spill->buffer = (unsigned char *)malloc((size_t)spill->capacity * recordSize);
+    if (spill->path == NULL || spill->buffer == NULL)
+    {
+        free(spill->path);
+        free(spill->buffer);
+        free(spill);
+        return NULL;
+    }
+    return spill;
+}
+
+// Sort buffered records and write them to a new run file, duplicates are written once
+// Returns false if file cannot be written
+static bool writeRun(Spill *spill)
+{
+    sortKeySize = spill->keySize;
+    qsort(spill->buffer, spill->buffered, spill->recordSize, compareKeys);
+    FILE *file = fopen(filePath(spill, "run", spill->runs), "wb");
+    if (file == NULL)
+        return false;
+    spill->runs++;
+    bool success = true;
+    for (long i = 0; i < spill->buffered && success; i++)
+    {
+        unsigned char *record = spill->buffer + i * spill->recordSize;
+        if (i == 0 || memcmp(record - spill->recordSize, record, spill->keySize) != 0)
+            success = fwrite(record, spill->recordSize, 1, file) == 1;
+    }
+    success = fclose(file) == 0 && success;
+    spill->buffered = 0;
+    return success;
+}
+
+// Add record to the layer being built
+// Returns false if a full buffer cannot be written to disk
+bool addRecord(Spill *spill, void *record)
+{
+    if (spill->buffered == spill->capacity && !writeRun(spill))
+        return false;
+    memcpy(spill->buffer + spill->buffered * spill->recordSize, record, spill->recordSize);
+    spill->buffered++;
+    return true;
+}
+
+// Index of run whose next record has the smallest key, -1 if every run is finished
+static int findSmallest(Spill *spill, unsigned char **runs, long *counts, long *positions)
+{
+    int smallest = -1;
+    for (int i = 0; i < spill->runs; i++)
+    {
+        if (positions[i] == counts[i])
+            continue;
+        if (smallest == -1 || memcmp(runs[i] + positions[i] * spill->recordSize, runs[smallest] + positions[smallest] * spill->recordSize, spill->keySize) < 0)
+            smallest = i;
+    }
+    return smallest;
+}
+
+// Merge sorted runs into the next layer file, leaving out records visited in earlier layers
+// Visited set is replaced with a file holding its old keys and the keys of the new layer
+// Returns number of records in new layer, -1 if files cannot be read or written
+static long mergeRuns(Spill *spill, unsigned char **runs, long *counts, long *positions)
+{
+    unsigned char *visited = NULL; // keys of earlier layers
+    long visitedCount = 0;
+    if (spill->layers > 0 && !mapFile(filePath(spill, "visited", spill->layers - 1), spill->keySize, &visited, &visitedCount))
+        return -1;
+    FILE *layer = fopen(filePath(spill, "layer", spill->layers), "wb");
+    FILE *newVisited = fopen(filePath(spill, "visited", spill->layers), "wb");
+    bool success = layer != NULL && newVisited != NULL;
+
+    long added = 0;
+    long old = 0;               // position in old visited set
+    unsigned char *last = NULL; // key of previous record, runs can hold the same key
+    for (int run = findSmallest(spill, runs, counts, positions); run != -1 && success; run = findSmallest(spill, runs, counts, positions))
+    {
+        unsigned char *record = runs[run] + positions[run]++ * spill->recordSize;
+        if (last != NULL && memcmp(last, record, spill->keySize) == 0)
+            continue;
+        last = record;
+        while (old < visitedCount && memcmp(visited + old * spill->keySize, record, spill->keySize) < 0 && success) // copy smaller visited keys
+            success = fwrite(visited + old++ * spill->keySize, spill->keySize, 1, newVisited) == 1;
+        if (old < visitedCount && memcmp(visited + old * spill->keySize, record, spill->keySize) == 0)
+            continue; // reached in an earlier layer
+        success = success && fwrite(record, spill->recordSize, 1, layer) == 1 && fwrite(record, spill->keySize, 1, newVisited) == 1;
+        added++;
+    }
+    while (old < visitedCount && success)
+        success = fwrite(visited + old++ * spill->keySize, spill->keySize, 1, newVisited) == 1;
+
+    if (layer != NULL)
+        success = fclose(layer) == 0 && success;
+    if (newVisited != NULL)
+        success = fclose(newVisited) == 0 && success;
+    unmapFile(visited, visitedCount, spill->keySize);
+    if (spill->layers > 0)
+        remove(filePath(spill, "visited", spill->layers - 1));
+    spill->layers++;
+    return success ? added : -1;
+}
+
+// Finish the layer being built, records reached in earlier layers or more than once are removed
+// Layers are numbered from 0 in order of finishing
+// Returns number of records in the finished layer, -1 if files cannot be read or written
+long finishLayer(Spill *spill)
+{
+    if (spill->buffered > 0 && !writeRun(spill))
+        return -1;
+    unsigned char **runs = (unsigned char **)calloc(spill->runs + 1, sizeof(unsigned char *));
+    long *counts = (long *)calloc(spill->runs + 1, sizeof(long));
+    long *positions = (long *)calloc(spill->runs + 1, sizeof(long));
+    bool success = runs != NULL && counts != NULL && positions != NULL;
+    for (int i = 0; i < spill->runs && success; i++)
+        success = mapFile(filePath(spill, "run", i), spill->recordSize, &runs[i], &counts[i]);
+
+    long added = success ? mergeRuns(spill, runs, counts, positions) : -1;
+
+    for (int i = 0; i < spill->runs; i++)
+    {
+        if (runs != NULL)
+            unmapFile(runs[i], counts[i], spill->recordSize);
+        remove(filePath(spill, "run", i));
+    }
+    spill->runs = 0;
+    free(runs);
+    free(counts);
+    free(positions);
+    return added;
+}
+
+// Map records of finished layer for reading
+// Returns false if file cannot be read
+bool mapLayer(Spill *spill, int layer, unsigned char **records, long *count)
+{
+    return mapFile(filePath(spill, "layer", layer), spill->recordSize, records, count);
+}
+
+// Release records mapped by mapLayer
+void unmapLayer(Spill *spill, unsigned char *records, long count)
+{
+    unmapFile(records, count, spill->recordSize);
+}
+
+// Remove files of spill and free its memory
+void closeSpill(Spill *spill)
+{
+    if (spill == NULL)
+        return;
+    for (int i = 0; i < spill->runs; i++) // runs of unfinished layer
+        remove(filePath(spill, "run", i));
+    for (int i = 0; i < spill->layers; i++)
+        remove(filePath(spill, "layer", i));
+    if (spill->layers > 0)
+        remove(filePath(spill, "visited", spill->layers - 1));
+    free(spill->path);
+    free(spill->buffer);
+    free(spill);
+}
@@ -0,0 +1,16 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct Spill Spill;
+
+Spill *openSpill(char *directory, int recordSize, int keySize, size_t memory);
+bool addRecord(Spill *spill, void *record);
+long finishLayer(Spill *spill);
+bool mapLayer(Spill *spill, int layer, unsigned char **records, long *count);
+void unmapLayer(Spill *spill, unsigned char *records, long count);
+void closeSpill(Spill *spill);
+
+#endif
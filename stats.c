@@ -0,0 +1,224 @@
+#include "stats.h"
+#include "tiles.h"
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "debugmalloc.h"
+#endif
+
+#define MAX_SAMPLES 1048576 // frames after this many are not recorded
+
+// Samples of one measured value
+typedef struct Samples
+{
+    double *values;
+    int count;
+    int capacity;
+} Samples;
+
+// Frame statistics, collected only if SOKOBAN_STATS environment variable is set
+// SOKOBAN_STATS=hud shows the overlay from start, F3 toggles it
+// SOKOBAN_STATS_LOG=<file> writes every frame as a tab separated line
+static struct
+{
+    bool enabled;
+    bool hud;
+    TTF_Font *font;
+    FILE *log;
+    Uint64 frequency;
+    Uint64 start;     // performance counter at program start, 0 after first frame
+    double startup;   // ms from program start to first presented frame
+    Uint64 pending;   // arrival of first input event not presented yet, 0 if there is none
+    int copies;       // SDL_RenderCopy calls of current frame
+    Uint64 textTicks; // time spent in TTF rendering in current frame
+    long frames;
+    Samples latency; // input event to present, ms
+    Samples copyCount;
+    Samples textTime; // ms
+    double last[3];   // latency, copies and text time of last frame for the overlay
+} stats;
+
+// Append sample, silently dropped on memory allocation failure
+static void addSample(Samples *samples, double value)
+{
+    if (samples->count == samples->capacity)
+    {
+        if (samples->capacity == MAX_SAMPLES)
+            return;
+        int capacity = samples->capacity == 0 ? 1024 : samples->capacity * 2;
+        double *values = (double *)realloc(samples->values, sizeof(double) * capacity);
+        if (values == NULL)
+            return;
+        samples->values = values;
+        samples->capacity = capacity;
+    }
+    samples->values[samples->count++] = value;
+}
+
+// Called by SDL when an event is added to the queue
+// Stores arrival of input and toggles overlay on F3
+static int SDLCALL watchEvent(void *data, SDL_Event *event)
+{
+    (void)data;
+    switch (event->type)
+    {
+    case SDL_KEYDOWN:
+        if (event->key.keysym.scancode == 0x3c && !event->key.repeat) // F3
+            stats.hud = !stats.hud;
+        // fall through, key press is input too
+    case SDL_KEYUP:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+    case SDL_TEXTINPUT:
+    case SDL_QUIT:
+        if (stats.pending == 0)
+            stats.pending = SDL_GetPerformanceCounter();
+        break;
+    default:
+        break;
+    }
+    return 1;
+}
+
+// Start collecting statistics if SOKOBAN_STATS is set
+// Font is used by the overlay, start: performance counter at start of program
+void initStats(TTF_Font *font, Uint64 start)
+{
+    char *mode = SDL_getenv("SOKOBAN_STATS");
+    if (mode == NULL)
+        return;
+    memset(&stats, 0, sizeof(stats));
+    stats.enabled = true;
+    stats.hud = strcmp(mode, "hud") == 0;
+    stats.font = font;
+    stats.frequency = SDL_GetPerformanceFrequency();
+    stats.start = start;
+    char *log = SDL_getenv("SOKOBAN_STATS_LOG");
+    if (log != NULL)
+    {
+        stats.log = fopen(log, "w");
+        if (stats.log != NULL)
+            fprintf(stats.log, "frame\tlatency_ms\tcopies\ttext_ms\n");
+    }
+    SDL_AddEventWatch(watchEvent, NULL);
+}
+
+// Count one SDL_RenderCopy call of current frame
+void countCopy(void)
+{
+    stats.copies++;
+}
+
+// Add time spent in TTF rendering to current frame
+// Ticks: performance counter difference
+void addTextTime(Uint64 ticks)
+{
+    stats.textTicks += ticks;
+}
+
+// Draw overlay with values of last frame
+static void renderHud(SDL_Renderer *renderer)
+{
+    char text[96];
+    if (stats.last[0] < 0)
+        sprintf(text, "%.0f másolás, szöveg %.2f ms", stats.last[1], stats.last[2]);
+    else
+        sprintf(text, "%.2f ms, %.0f másolás, szöveg %.2f ms", stats.last[0], stats.last[1], stats.last[2]);
+
+    SDL_Rect background = {64, 64 * 10 + 12, 64 * 18, 40};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(renderer, &background);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_Color yellow = {255, 230, 80, 255};
+    renderFont(renderer, stats.font, yellow, text, 10, 10, true, true);
+}
+
+// Present rendered frame, recording its statistics first
+// Every screen presents through this, so all frames are measured
+void presentFrame(SDL_Renderer *renderer)
+{
+    if (!stats.enabled)
+    {
+        SDL_RenderPresent(renderer);
+        return;
+    }
+
+    double copies = stats.copies;
+    double text = stats.textTicks * 1000.0 / stats.frequency;
+    if (stats.hud) // overlay itself is not measured
+        renderHud(renderer);
+    SDL_RenderPresent(renderer);
+
+    if (stats.start != 0) // first frame the user can interact with
+    {
+        stats.startup = (SDL_GetPerformanceCounter() - stats.start) * 1000.0 / stats.frequency;
+        stats.start = 0;
+    }
+
+    double latency = -1; // frames without input, like animations, have no latency
+    if (stats.pending != 0)
+    {
+        latency = (SDL_GetPerformanceCounter() - stats.pending) * 1000.0 / stats.frequency;
+        stats.pending = 0;
+        addSample(&stats.latency, latency);
+    }
+    addSample(&stats.copyCount, copies);
+    addSample(&stats.textTime, text);
+    if (stats.log != NULL)
+        fprintf(stats.log, "%ld\t%.3f\t%.0f\t%.3f\n", stats.frames, latency, copies, text);
+    stats.frames++;
+    stats.last[0] = latency;
+    stats.last[1] = copies;
+    stats.last[2] = text;
+    stats.copies = 0;
+    stats.textTicks = 0;
+}
+
+// Order samples ascending
+static int compareSamples(const void *a, const void *b)
+{
+    double first = *(const double *)a, second = *(const double *)b;
+    return (first > second) - (first < second);
+}
+
+// Print percentiles of samples as a tab separated line: name, count, p50, p90, p99, max
+static void printPercentiles(char *name, Samples *samples)
+{
+    if (samples->count == 0)
+    {
+        printf("%s\t0\n", name);
+        return;
+    }
+    qsort(samples->values, samples->count, sizeof(double), compareSamples);
+    double *v = samples->values;
+    int n = samples->count;
+    printf("%s\t%d\t%.3f\t%.3f\t%.3f\t%.3f\n", name, n, v[n * 50 / 100], v[n * 90 / 100], v[n * 99 / 100], v[n - 1]);
+}
+
+// Print percentiles of collected statistics and stop collecting
+void reportStats(void)
+{
+    if (!stats.enabled)
+        return;
+    SDL_DelEventWatch(watchEvent, NULL);
+    printf("startup_ms\t%.3f\n", stats.startup);
+    printf("stat\tcount\tp50\tp90\tp99\tmax\n");
+    printPercentiles("latency_ms", &stats.latency);
+    printPercentiles("copies", &stats.copyCount);
+    printPercentiles("text_ms", &stats.textTime);
+    if (stats.log != NULL)
+        fclose(stats.log);
+    free(stats.latency.values);
+    free(stats.copyCount.values);
+    free(stats.textTime.values);
+    memset(&stats, 0, sizeof(stats));
+}
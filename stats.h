@@ -0,0 +1,13 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+void initStats(TTF_Font *font, Uint64 start);
+void countCopy(void);
+void addTextTime(Uint64 ticks);
+void presentFrame(SDL_Renderer *renderer);
+void reportStats(void);
+
+#endif
@@ -1,5 +1,6 @@
 #include "tiles.h"
 #include "coordinates.h"
+#include "stats.h"
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -10,9 +11,9 @@
 #include "debugmalloc.h"
 #endif
 
-// Translate tile type to coordinates of the tile
+// Translate tile type to coordinates of the tile in tiles image
 // Returns SDL_rect
-static SDL_Rect toSourceRect(Tile tile)
+SDL_Rect toSourceRect(Tile tile)
 {
     SDL_Rect src;
     src.w = 64;
@@ -108,6 +109,10 @@ static SDL_Rect toSourceRect(Tile tile)
         src.x = 6;
         src.y = 2;
         break;
+    case levels:
+        src.x = 1;
+        src.y = 3;
+        break;
     default:
         src.x = 0;
         src.y = 0;
@@ -128,6 +133,18 @@ void renderTile(SDL_Renderer *renderer, SDL_Texture *tiles, Tile tile, int x, in
     SDL_Rect dst = {64 * x, 64 * y, 64, 64};
 
     SDL_RenderCopy(renderer, tiles, &src, &dst);
+    countCopy();
+}
+
+// Render tile to renderer at pixel coordinates, used for tiles moving between blocks
+// Texture must include proper tiles file
+void renderTileAt(SDL_Renderer *renderer, SDL_Texture *tiles, Tile tile, int x, int y)
+{
+    SDL_Rect src = toSourceRect(tile);
+    SDL_Rect dst = {x, y, 64, 64};
+
+    SDL_RenderCopy(renderer, tiles, &src, &dst);
+    countCopy();
 }
 
 // Render tile to renderer. Coordinates map to whole blocks
@@ -175,13 +192,16 @@ void renderFont(SDL_Renderer *renderer, TTF_Font *font, SDL_Color color, char *t
     SDL_Texture *textTexture;
     SDL_Rect destination;
 
+    Uint64 start = SDL_GetPerformanceCounter();
     textSurface = TTF_RenderUTF8_Solid(font, text, color);
     textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
+    addTextTime(SDL_GetPerformanceCounter() - start);
     destination.x = centeredX ? x - textSurface->w / 2 : x;
     destination.y = centeredY ? y - textSurface->h / 2 : y;
     destination.w = textSurface->w;
     destination.h = textSurface->h;
     SDL_RenderCopy(renderer, textTexture, NULL, &destination);
+    countCopy();
     SDL_FreeSurface(textSurface);
     SDL_DestroyTexture(textTexture);
 }
@@ -31,10 +31,14 @@ typedef enum Tile
     blankLR,
     retry,
     selection,
-    delete
+    delete,
+    levels
 } Tile;
 
+SDL_Rect toSourceRect(Tile tile);
+
 void renderTile(SDL_Renderer *renderer, SDL_Texture *tiles, Tile tile, int x, int y);
+void renderTileAt(SDL_Renderer *renderer, SDL_Texture *tiles, Tile tile, int x, int y);
 void renderTileC(SDL_Renderer *renderer, SDL_Texture *tiles, Tile tile, Coordinates pos);
 void renderTiles(SDL_Renderer *renderer, SDL_Texture *tiles, Tile tile, int x1, int y1, int x2, int y2);
 void renderTilesC(SDL_Renderer *renderer, SDL_Texture *tiles, Tile tile, Coordinates pos1, Coordinates pos2);
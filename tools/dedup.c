@@ -0,0 +1,181 @@
+#include "../file.h"
+#include "../canon.h"
+#include "../progress.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef DEBUGMALLOC
+#include "../debugmalloc.h"
+#endif
+
+typedef struct Entry
+{
+    unsigned long long hash;
+    Level *level; // canonical form, NULL for empty slot
+    int file;     // index of file in arguments
+    int number;   // number of level in file, starting from 1
+} Entry;
+
+typedef struct Table
+{
+    Entry *entries;
+    int capacity; // power of two
+    int count;
+} Table;
+
+// Double size of table
+// Returns false on memory allocation failure
+static bool growTable(Table *table)
+{
+    int capacity = table->capacity == 0 ? 1024 : table->capacity * 2;
+    Entry *entries = (Entry *)calloc(capacity, sizeof(Entry));
+    if (entries == NULL)
+        return false;
+    for (int i = 0; i < table->capacity; i++)
+    {
+        if (table->entries[i].level == NULL)
+            continue;
+        int slot = (int)(table->entries[i].hash & (capacity - 1));
+        while (entries[slot].level != NULL)
+            slot = (slot + 1) & (capacity - 1);
+        entries[slot] = table->entries[i];
+    }
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+    return true;
+}
+
+// Find canonical level in table, or insert it if it is not there yet
+// Returns the entry that was there before, NULL if level was inserted
+// Failed is set if the table could not grow
+static Entry *findOrInsert(Table *table, Entry entry, bool *failed)
+{
+    *failed = false;
+    if ((table->count + 1) * 2 > table->capacity && !growTable(table))
+    {
+        *failed = true;
+        return NULL;
+    }
+    int slot = (int)(entry.hash & (table->capacity - 1));
+    while (table->entries[slot].level != NULL)
+    {
+        if (table->entries[slot].hash == entry.hash && sameTiles(table->entries[slot].level, entry.level))
+            return &table->entries[slot];
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    table->entries[slot] = entry;
+    table->count++;
+    return NULL;
+}
+
+// Normalize levels of collections and find duplicates among them
+// Usage: dedup [-r] [-o <output.xsb>] <levels.xsb>...
+// Duplicates are printed as tab separated lines, first occurrence of each level is written to output in canonical form
+// -r writes output with run length encoded rows
+// Returns 0 if there were no errors
+int main(int argc, char **argv)
+{
+#ifdef DEBUGMALLOC
+    debugmalloc_max_block_size(DEBUGMALLOC_BLOCK_SIZE); // large collections need blocks over the default 1 MB
+#endif
+    char *output = NULL;
+    bool rle = false;
+    int first = 1;
+    if (first < argc && strcmp(argv[first], "-r") == 0)
+    {
+        rle = true;
+        first++;
+    }
+    if (first + 1 < argc && strcmp(argv[first], "-o") == 0)
+    {
+        output = argv[first + 1];
+        first += 2;
+    }
+    if (first >= argc)
+    {
+        printf("Usage: %s [-r] [-o <output.xsb>] <levels.xsb>...\n", argv[0]);
+        return 2;
+    }
+
+    Table table = {NULL, 0, 0};
+    Level *unique = NULL; // canonical levels in order of first occurrence
+    Level *last = NULL;
+    int total = 0, duplicates = 0, status = 0;
+    bool memoryError = false;
+    double seconds = 0;
+    for (int f = first; f < argc && !memoryError; f++)
+    {
+        LoadLevelResult levels = loadLevel(argv[f]);
+        if (levels.result != 0 && levels.result != 4) // other collections can still be checked
+        {
+            printf("ERROR: Couldn't load %s (%d)\n", argv[f], levels.result);
+            unloadLevel(levels.level);
+            status = 1;
+            continue;
+        }
+        clock_t start = clock();
+        int number = 0;
+        for (Level *level = levels.level; level != NULL; level = level->next)
+        {
+            number++;
+            total++;
+            Level *canon = normalizeLevel(level);
+            if (canon == NULL)
+            {
+                memoryError = true;
+                break;
+            }
+            Entry entry = {hashLevel(canon), canon, f, number};
+            bool failed;
+            Entry *previous = findOrInsert(&table, entry, &failed);
+            if (failed)
+            {
+                freeLevel(canon);
+                memoryError = true;
+                break;
+            }
+            if (previous != NULL)
+            {
+                duplicates++;
+                printf("duplicate\t%s:%d\t%s\t%s:%d\t%s\t%016llx\n", argv[f], number, level->name,
+                       argv[previous->file], previous->number, previous->level->name, entry.hash);
+                freeLevel(canon);
+                continue;
+            }
+            canon->prev = last; // keep first occurrence for output
+            if (last != NULL)
+                last->next = canon;
+            else
+                unique = canon;
+            last = canon;
+        }
+        seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+        unloadLevel(levels.level);
+    }
+    if (memoryError)
+    {
+        printf("ERROR: Memory allocation failed\n");
+        status = 2;
+    }
+
+    printf("levels\t%d\n", total);
+    printf("unique\t%d\n", total - duplicates);
+    printf("duplicates\t%d\n", duplicates);
+    if (seconds > 0)
+        printf("levels_per_second\t%.0f\n", total / seconds);
+
+    if (!memoryError && output != NULL && unique != NULL && !saveLevel(unique, output, rle))
+    {
+        printf("ERROR: Couldn't save %s\n", output);
+        status = 2;
+    }
+
+    unloadLevel(unique);
+    free(table.entries);
+    return status;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Write contents of file as a byte array and its size
+// Returns false if file cannot be read
+static bool writeArray(FILE *output, char *name, char *filename)
+{
+    FILE *input = fopen(filename, "rb");
+    if (input == NULL)
+        return false;
+    fprintf(output, "\nconst unsigned char %s[] = {", name);
+    long size = 0;
+    int c;
+    while ((c = fgetc(input)) != EOF)
+    {
+        fprintf(output, size % 16 == 0 ? "\n    %d," : " %d,", c);
+        size++;
+    }
+    fprintf(output, "\n};\nconst size_t %sSize = %ld;\n", name, size);
+    fclose(input);
+    return true;
+}
+
+// Generate C source embedding files as byte arrays
+// Usage: embed <output.c> <name> <file> [<name> <file>...]
+// Returns 0 on success
+int main(int argc, char **argv)
+{
+    if (argc < 4 || argc % 2 != 0)
+    {
+        printf("Usage: %s <output.c> <name> <file> [<name> <file>...]\n", argv[0]);
+        return 2;
+    }
+    FILE *output = fopen(argv[1], "w");
+    if (output == NULL)
+    {
+        printf("ERROR: Couldn't create %s\n", argv[1]);
+        return 1;
+    }
+    fprintf(output, "// Generated by tools/embed.c, do not edit\n\n#include <stddef.h>\n");
+    for (int i = 2; i < argc; i += 2)
+    {
+        if (!writeArray(output, argv[i], argv[i + 1]))
+        {
+            printf("ERROR: Couldn't read %s\n", argv[i + 1]);
+            fclose(output);
+            remove(argv[1]);
+            return 1;
+        }
+    }
+    if (fclose(output) != 0)
+    {
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "../file.h"
+#include "../generator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <time.h>
+
+#ifdef DEBUGMALLOC
+#include "../debugmalloc.h"
+#endif
+
+// State shared by generator threads
+typedef struct Shared
+{
+    GeneratorParams params;
+    mtx_t mutex;
+    GeneratedLevel *kept; // levels accepted so far, guarded by mutex
+    int count;            // number of levels wanted
+    int keptCount;
+    atomic_int done;      // set when enough levels are kept or memory ran out
+    atomic_long candidates;
+    bool memoryError;
+    unsigned long long seed;
+} Shared;
+
+typedef struct Worker
+{
+    Shared *shared;
+    unsigned long long seed;
+} Worker;
+
+// Get current time in seconds
+static double now(void)
+{
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// Generate levels until enough are kept
+static int workerThread(void *data)
+{
+    Worker *worker = (Worker *)data;
+    Shared *shared = worker->shared;
+    while (!atomic_load(&shared->done))
+    {
+        GeneratedLevel level = generateLevel(&shared->params, &worker->seed);
+        atomic_fetch_add(&shared->candidates, 1);
+        if (level.result == 1)
+            continue;
+
+        mtx_lock(&shared->mutex);
+        if (level.result == 2)
+        {
+            shared->memoryError = true;
+            atomic_store(&shared->done, 1);
+        }
+        else if (shared->keptCount < shared->count)
+        {
+            shared->kept[shared->keptCount++] = level;
+            printf("kept\t%d\t%d\t%d\t%ld\t%d\n", shared->keptCount, level.moves, level.pushes, level.nodes, level.score);
+            fflush(stdout);
+            level.level = NULL;
+            if (shared->keptCount == shared->count)
+                atomic_store(&shared->done, 1);
+        }
+        mtx_unlock(&shared->mutex);
+        freeLevel(level.level); // generated too late
+    }
+    return 0;
+}
+
+// Order levels by difficulty
+static int compareScore(const void *a, const void *b)
+{
+    const GeneratedLevel *first = (const GeneratedLevel *)a;
+    const GeneratedLevel *second = (const GeneratedLevel *)b;
+    return first->score - second->score;
+}
+
+// Name and link kept levels in order of difficulty, then save them
+// Returns false on memory allocation or saving failure
+static bool saveKept(Shared *shared, char *filename)
+{
+    qsort(shared->kept, shared->keptCount, sizeof(GeneratedLevel), compareScore);
+    for (int i = 0; i < shared->keptCount; i++)
+    {
+        Level *level = shared->kept[i].level;
+        char name[64];
+        sprintf(name, "Generált %d (%d tolás)", i + 1, shared->kept[i].pushes);
+        level->name = (char *)malloc(strlen(name) + 1);
+        if (level->name == NULL)
+            return false;
+        strcpy(level->name, name);
+        level->prev = i > 0 ? shared->kept[i - 1].level : NULL;
+        level->next = i + 1 < shared->keptCount ? shared->kept[i + 1].level : NULL;
+    }
+    return shared->keptCount == 0 || saveLevel(shared->kept[0].level, filename, false);
+}
+
+// Generate solver verified levels on multiple threads and save them in order of difficulty
+// Usage: generate <output.xsb> <count> [width height crates threads seed]
+// Kept levels are printed as tab separated lines: number, moves, pushes, solver nodes, score
+// Returns 0 if every requested level was generated and saved
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <output.xsb> <count> [width height crates threads seed]\n", argv[0]);
+        return 2;
+    }
+    Shared shared;
+    shared.count = atoi(argv[2]);
+    shared.params.size.x = argc > 3 ? atoi(argv[3]) : 10;
+    shared.params.size.y = argc > 4 ? atoi(argv[4]) : 9;
+    shared.params.crates = argc > 5 ? atoi(argv[5]) : 3;
+    int threads = argc > 6 ? atoi(argv[6]) : 4;
+    shared.seed = argc > 7 ? strtoull(argv[7], NULL, 10) : (unsigned long long)time(NULL);
+    if (shared.count < 1 || shared.params.size.x < 3 || shared.params.size.y < 3 || shared.params.size.x > 19 || shared.params.size.y > 11 ||
+        shared.params.crates < 1 || threads < 1 || threads > 256)
+    {
+        printf("ERROR: Invalid arguments\n");
+        return 2;
+    }
+    shared.params.wallPercent = 20;
+    shared.params.pulls = shared.params.crates * 12;
+    shared.params.minPushes = shared.params.crates * 3;
+    shared.params.limits.maxNodes = 200000;
+    shared.params.limits.maxSeconds = 0.5; // hard candidates are cheaper to replace than to prove
+    shared.params.limits.cancel = &shared.done; // stop long searches once enough levels are kept
+    shared.params.limits.spillDirectory = NULL;
+    shared.params.limits.macros = false; // difficulty is scored on the least possible pushes
+    shared.keptCount = 0;
+    shared.memoryError = false;
+    atomic_init(&shared.done, 0);
+    atomic_init(&shared.candidates, 0);
+    shared.kept = (GeneratedLevel *)malloc(sizeof(GeneratedLevel) * shared.count);
+    Worker *workers = (Worker *)malloc(sizeof(Worker) * threads);
+    thrd_t *ids = (thrd_t *)malloc(sizeof(thrd_t) * threads);
+    if (shared.kept == NULL || workers == NULL || ids == NULL || mtx_init(&shared.mutex, mtx_plain) != thrd_success)
+    {
+        printf("ERROR: Memory allocation failed\n");
+        free(shared.kept);
+        free(workers);
+        free(ids);
+        return 2;
+    }
+
+    double start = now();
+    int started = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i].shared = &shared;
+        workers[i].seed = (shared.seed + 1) * 0x9E3779B97F4A7C15ULL + (unsigned long long)i * 0xBF58476D1CE4E5B9ULL; // seeds must not be zero
+        if (workers[i].seed == 0)
+            workers[i].seed = 1;
+        if (thrd_create(&ids[i], workerThread, &workers[i]) != thrd_success)
+            break;
+        started++;
+    }
+    if (started == 0)
+        workerThread(&workers[0]); // generate on main thread
+    for (int i = 0; i < started; i++)
+        thrd_join(ids[i], NULL);
+    double seconds = now() - start;
+
+    int status = 0;
+    if (shared.memoryError)
+    {
+        printf("ERROR: Memory allocation failed\n");
+        status = 2;
+    }
+    else if (!saveKept(&shared, argv[1]))
+    {
+        printf("ERROR: Couldn't save %s\n", argv[1]);
+        status = 2;
+    }
+    printf("seed\t%llu\n", shared.seed);
+    printf("candidates\t%ld\n", atomic_load(&shared.candidates));
+    printf("kept\t%d\n", shared.keptCount);
+    if (seconds > 0)
+        printf("levels_per_minute\t%.0f\n", shared.keptCount * 60 / seconds);
+
+    for (int i = 0; i < shared.keptCount; i++)
+    {
+        free(shared.kept[i].level->name);
+        free(shared.kept[i].level->tiles);
+        free(shared.kept[i].level);
+    }
+    mtx_destroy(&shared.mutex);
+    free(shared.kept);
+    free(workers);
+    free(ids);
+    return status;
+}
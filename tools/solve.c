@@ -0,0 +1,73 @@
+#include "../file.h"
+#include "../solver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DEBUGMALLOC
+#include "../debugmalloc.h"
+#endif
+
+// Solve every level of a collection
+// Usage: solve [-m] [-d <directory>] [-n <max nodes>] [-t <seconds>] <levels.xsb>
+// -m uses tunnel and goal room macro moves, searching far fewer positions, but pushes are not necessarily the least
+// -d keeps positions of the search in files of directory, for levels needing more positions than fit in memory
+// Results are printed as tab separated lines: number, name, result, moves, pushes, nodes, seconds, solution
+// Returns 0 if every level was solved
+int main(int argc, char **argv)
+{
+#ifdef DEBUGMALLOC
+    debugmalloc_max_block_size(DEBUGMALLOC_BLOCK_SIZE); // search tables grow past the default 1 MB
+#endif
+    SolverLimits limits = {0, 0, NULL, NULL, false};
+    int first = 1;
+    while (first + 1 < argc && argv[first][0] == '-')
+    {
+        if (strcmp(argv[first], "-m") == 0)
+        {
+            limits.macros = true;
+            first++;
+            continue;
+        }
+        if (strcmp(argv[first], "-d") == 0)
+            limits.spillDirectory = argv[first + 1];
+        else if (strcmp(argv[first], "-n") == 0)
+            limits.maxNodes = atol(argv[first + 1]);
+        else if (strcmp(argv[first], "-t") == 0)
+            limits.maxSeconds = atof(argv[first + 1]);
+        else
+            break;
+        first += 2;
+    }
+    if (first + 1 != argc)
+    {
+        printf("Usage: %s [-m] [-d <directory>] [-n <max nodes>] [-t <seconds>] <levels.xsb>\n", argv[0]);
+        return 2;
+    }
+
+    LoadLevelResult levels = loadLevel(argv[first]);
+    if (levels.result != 0 && levels.result != 4)
+    {
+        printf("ERROR: Couldn't load levels (%d)\n", levels.result);
+        return 2;
+    }
+
+    int count = 0;
+    int solved = 0;
+    for (Level *level = levels.level; level != NULL; level = level->next)
+    {
+        count++;
+        SolverResult result = solveLevel(level, limits);
+        printf("%d\t%s\t%d\t%d\t%d\t%ld\t%.2f\t%s\n", count, level->name, result.result, result.moves, result.pushes, result.nodes, result.seconds,
+               result.solution == NULL ? "" : result.solution);
+        fflush(stdout); // long searches are followed line by line
+        if (result.result == 0)
+            solved++;
+        freeSolverResult(&result);
+    }
+
+    printf("solved\t%d\t%d\n", solved, count);
+    unloadLevel(levels.level);
+    return solved == count ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include "../file.h"
+#include "../replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef DEBUGMALLOC
+#include "../debugmalloc.h"
+#endif
+
+// Read next solution from file
+// Solutions are separated by empty lines or "; comment" lines, a solution may span multiple lines
+// Returns false if there are no more solutions
+static bool readSolution(FILE *file, MoveList *list)
+{
+    clearMoves(list);
+    bool lineStart = true;
+    bool comment = false;
+    int c;
+    while ((c = fgetc(file)) != EOF)
+    {
+        if (c == '\n')
+        {
+            if (lineStart && list->length > 0) // empty line ends solution
+                return true;
+            lineStart = true;
+            comment = false;
+            continue;
+        }
+        if (lineStart && c == ';')
+        {
+            if (list->length > 0) // comment ends solution
+            {
+                ungetc(c, file);
+                return true;
+            }
+            comment = true;
+        }
+        lineStart = false;
+        bool push;
+        int dir = charToMove((char)c, &push);
+        if (!comment && dir != -1 && !appendMove(list, dir, push))
+            return false;
+    }
+    return list->length > 0;
+}
+
+// Verify solutions of a level collection
+// Usage: verify <levels.xsb> <solutions.txt> [repeat count]
+// Solutions are matched to levels by order, results are printed as tab separated lines
+// Returns 0 if every level has a valid solution
+int main(int argc, char **argv)
+{
+#ifdef DEBUGMALLOC
+    debugmalloc_max_block_size(DEBUGMALLOC_BLOCK_SIZE); // large collections need blocks over the default 1 MB
+#endif
+    if (argc < 3)
+    {
+        printf("Usage: %s <levels.xsb> <solutions.txt> [repeat count]\n", argv[0]);
+        return 2;
+    }
+    int repeat = argc > 3 ? atoi(argv[3]) : 1;
+    if (repeat < 1)
+        repeat = 1;
+
+    LoadLevelResult levels = loadLevel(argv[1]);
+    if (levels.result != 0 && levels.result != 4)
+    {
+        printf("ERROR: Couldn't load levels (%d)\n", levels.result);
+        return 2;
+    }
+
+    FILE *file = fopen(argv[2], "r");
+    if (file == NULL)
+    {
+        printf("ERROR: Couldn't open solutions\n");
+        unloadLevel(levels.level);
+        return 2;
+    }
+
+    MoveList solution;
+    initMoves(&solution);
+    int count = 0;
+    int valid = 0;
+    long replayed = 0; // timed replays, missing solutions excluded
+    double seconds = 0;
+    for (Level *level = levels.level; level != NULL; level = level->next)
+    {
+        count++;
+        if (!readSolution(file, &solution))
+        {
+            printf("%d\t%s\tmissing\n", count, level->name);
+            continue;
+        }
+
+        ReplayResult result;
+        clock_t start = clock();
+        for (int i = 0; i < repeat; i++) // repeat only for timing
+            result = verifySolution(level, solution.moves);
+        seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+        replayed += repeat;
+
+        if (result.result == 0 && result.finished)
+        {
+            valid++;
+            printf("%d\t%s\tok\t%d\t%d\n", count, level->name, result.moves, result.pushes);
+        }
+        else
+            printf("%d\t%s\tfailed\t%d\t%d\t%d\n", count, level->name, result.moves, result.pushes, result.result);
+    }
+
+    printf("verified\t%d\t%d\n", valid, count);
+    if (seconds > 0)
+        printf("solutions_per_second\t%.0f\n", replayed / seconds);
+
+    freeMoves(&solution);
+    fclose(file);
+    unloadLevel(levels.level);
+    return valid == count ? 0 : 1;
+}